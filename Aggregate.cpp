@@ -0,0 +1,459 @@
+/// ---------------- CLASS DESCRIPTION ----------------
+/// Aggregation of a select having aggregate functions and/or group by
+/// 1. indexBounds   => No condition and no group by. count from row count of table
+///                     and min / max of indexed columns from leftmost / rightmost leaf
+/// 2. sortAggregate => Group by column is indexed. Index gives rows in group order
+///                     so only current group is kept in memory
+/// 3. hashAggregate => Groups are kept in a hash table. Once AGGREGATE_MEMORY_LIMIT is reached
+///                     rows of new groups are spilled to partition files by hash of group
+///                     and every partition is aggregated after the scan
+///
+/// AggregatePlanner costs sortAggregate and hashAggregate in page reads like Optimizer
+
+#include <unordered_map>
+
+enum class AggregateStrategy{
+    indexBounds,
+    sortAggregate,
+    hashAggregate
+};
+
+/// Selected item of an aggregate select resolved against table
+struct AggregateColumn{
+    AggregateType type;
+    int32_t index;                  /// -1 for count(*)
+    DataType dataType;
+    int32_t offset;
+    int32_t size;
+};
+
+/// Running state of one aggregate of one group
+struct AggregateState{
+    int64_t count = 0;
+    int64_t intSum = 0;
+    double floatSum = 0;
+    std::string value;              /// Column bytes of current min / max
+    bool hasValue = false;
+};
+
+/// Converts column bytes to string in same format as Executor::deserializeRow
+inline std::string columnToString(const char* data, DataType type, int32_t size){
+    switch(type){
+        case DataType::Int: {
+            int32_t dataInt;
+            memcpy(&dataInt, data, sizeof(int32_t));
+            return std::to_string(dataInt);
+        }
+        case DataType::Float: {
+            float dataFloat;
+            memcpy(&dataFloat, data, sizeof(float));
+            return std::to_string(dataFloat);
+        }
+        case DataType::Char:
+            return std::string(1, data[0]);
+        case DataType::Bool: {
+            bool dataBool;
+            memcpy(&dataBool, data, sizeof(bool));
+            return dataBool ? "true" : "false";
+        }
+        case DataType::String:
+            return std::string(data, strnlen(data, size));
+    }
+    return "";
+}
+
+/// Converts string to column bytes, inverse of columnToString
+inline bool stringToColumn(const std::string& str, DataType type, int32_t size, char* data){
+    try{
+        switch(type){
+            case DataType::Int: {
+                int32_t dataInt = std::stoi(str);
+                memcpy(data, &dataInt, sizeof(int32_t));
+                break;
+            }
+            case DataType::Float: {
+                float dataFloat = std::stof(str);
+                memcpy(data, &dataFloat, sizeof(float));
+                break;
+            }
+            case DataType::Char:
+                data[0] = str.empty() ? '\0' : str[0];
+                break;
+            case DataType::Bool: {
+                bool dataBool = (str == "true");
+                memcpy(data, &dataBool, sizeof(bool));
+                break;
+            }
+            case DataType::String:
+                memset(data, 0, size);
+                strncpy(data, str.c_str(), size);
+                break;
+        }
+    }
+    catch(...){
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+inline int compareFixed(const char* a, const char* b){
+    T x, y;
+    memcpy(&x, a, sizeof(T));
+    memcpy(&y, b, sizeof(T));
+    return (y < x) - (x < y);
+}
+
+/// Three way comparison of two values of a column
+inline int compareColumn(const char* a, const char* b, DataType type, int32_t size){
+    switch(type){
+        case DataType::Int:     return compareFixed<int32_t>(a, b);
+        case DataType::Float:   return compareFixed<float>(a, b);
+        case DataType::Char:    return compareFixed<char>(a, b);
+        case DataType::Bool:    return compareFixed<bool>(a, b);
+        case DataType::String:  return strncmp(a, b, size);
+    }
+    return 0;
+}
+
+class Aggregator{
+public:
+    std::vector<AggregateColumn> columns;
+    int32_t groupIndex = -1;
+    DataType groupType = DataType::Int;
+    int32_t groupOffset = 0;
+    int32_t groupSize = 0;
+
+    /// Resolves selected items of statement against table
+    ExecuteResult compile(Table* table, SelectStatement* statement){
+        if(!statement->groupBy.empty()){
+            auto itr = table->columnIndex.find(statement->groupBy);
+            if(itr == table->columnIndex.end()) return ExecuteResult::invalidColumnName;
+            groupIndex = itr->second;
+            groupType = table->columnTypes[groupIndex];
+            groupOffset = table->columnOffsets[groupIndex];
+            groupSize = table->columnSizes[groupIndex];
+        }
+
+        for(auto& aggregate: statement->aggregates){
+            AggregateColumn column{aggregate.type, -1, DataType::Int, 0, 0};
+            if(aggregate.col != "*"){
+                auto itr = table->columnIndex.find(aggregate.col);
+                if(itr == table->columnIndex.end()) return ExecuteResult::invalidColumnName;
+                column.index = itr->second;
+                column.dataType = table->columnTypes[column.index];
+                column.offset = table->columnOffsets[column.index];
+                column.size = table->columnSizes[column.index];
+            }
+
+            // Plain columns are only allowed if they are the group
+            if(column.type == AggregateType::none && (groupIndex == -1 || column.index != groupIndex)){
+                return ExecuteResult::invalidAggregate;
+            }
+            if((column.type == AggregateType::sum || column.type == AggregateType::avg) &&
+               column.dataType != DataType::Int && column.dataType != DataType::Float){
+                return ExecuteResult::typeMismatch;
+            }
+            columns.emplace_back(column);
+        }
+        return ExecuteResult::success;
+    }
+
+    std::string groupKey(const char* row) const{
+        if(groupIndex == -1) return "";
+        return joinKey(row, groupType, groupOffset, groupSize);
+    }
+
+    /// Adds row to states of its group
+    void update(std::vector<AggregateState>& states, const char* row) const{
+        for(size_t i = 0; i < columns.size(); ++i){
+            auto& column = columns[i];
+            auto& state = states[i];
+            const char* data = row + column.offset;
+            switch(column.type){
+                case AggregateType::none:
+                    break;
+
+                case AggregateType::count:
+                    ++state.count;
+                    break;
+
+                case AggregateType::sum:
+                case AggregateType::avg:
+                    ++state.count;
+                    if(column.dataType == DataType::Int){
+                        int32_t dataInt;
+                        memcpy(&dataInt, data, sizeof(int32_t));
+                        state.intSum += dataInt;
+                    }
+                    else{
+                        float dataFloat;
+                        memcpy(&dataFloat, data, sizeof(float));
+                        state.floatSum += dataFloat;
+                    }
+                    break;
+
+                case AggregateType::min:
+                case AggregateType::max: {
+                    int res = state.hasValue ? compareColumn(data, state.value.data(), column.dataType, column.size) : 0;
+                    if(!state.hasValue || (column.type == AggregateType::min ? res < 0 : res > 0)){
+                        state.value.assign(data, column.size);
+                        state.hasValue = true;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    /// Values of one group in select order
+    void finalize(const std::string& key, const std::vector<AggregateState>& states, std::vector<std::string>& out) const{
+        out.resize(columns.size());
+        for(size_t i = 0; i < columns.size(); ++i){
+            auto& column = columns[i];
+            auto& state = states[i];
+            switch(column.type){
+                case AggregateType::none:
+                    out[i] = columnToString(key.data(), groupType, key.size());
+                    break;
+                case AggregateType::count:
+                    out[i] = std::to_string(state.count);
+                    break;
+                case AggregateType::sum:
+                    out[i] = (column.dataType == DataType::Int) ? std::to_string(state.intSum) : std::to_string(state.floatSum);
+                    break;
+                case AggregateType::avg:
+                    if(state.count == 0) out[i] = "NULL";
+                    else if(column.dataType == DataType::Int) out[i] = std::to_string((double)state.intSum / state.count);
+                    else out[i] = std::to_string(state.floatSum / state.count);
+                    break;
+                case AggregateType::min:
+                case AggregateType::max:
+                    out[i] = state.hasValue ? columnToString(state.value.data(), column.dataType, column.size) : "NULL";
+                    break;
+            }
+        }
+    }
+
+    /// Approximate bytes held per group in a hash table
+    int64_t bytesPerGroup() const{
+        int64_t bytes = groupSize + 64;
+        for(auto& column: columns) bytes += sizeof(AggregateState) + column.size;
+        return bytes;
+    }
+
+    /// true if every item only reads group column, so index keys are enough
+    bool onlyReadsGroup() const{
+        return std::all_of(columns.begin(), columns.end(), [&](const AggregateColumn& column){
+            return column.index == -1 || column.index == groupIndex;
+        });
+    }
+
+};
+
+class HashAggregate{
+    const Aggregator& aggregator;
+    SortOptions options;                    /// Partitions are spilled to its temp directory
+    std::unordered_map<std::string, std::vector<AggregateState>> groups;
+    static const int32_t maxDepth = 8;
+
+public:
+    explicit HashAggregate(const Aggregator& aggregator_, const SortOptions& options_ = SortOptions()):
+            aggregator(aggregator_), options(options_) {}
+
+    /// Aggregates every row given by scan and calls emit(key, states) for every group
+    /// Rows of groups which don't fit in memory are spilled and aggregated afterwards
+    /// partition by partition, partitions are split again with another hash if needed
+    template <typename scan_t, typename emit_t>
+    bool run(scan_t& scan, int32_t rowSize, const emit_t& emit, int32_t depth = 0){
+        std::vector<std::string> fileNames;
+        bool res;
+        // Spill I/O throws, partitions are removed before error is passed on
+        try{
+            res = aggregate(scan, rowSize, emit, depth, fileNames);
+        }
+        catch(...){
+            removeFiles(fileNames);
+            throw;
+        }
+        removeFiles(fileNames);
+        return res;
+    }
+
+private:
+    template <typename scan_t, typename emit_t>
+    bool aggregate(scan_t& scan, int32_t rowSize, const emit_t& emit, int32_t depth, std::vector<std::string>& fileNames){
+        groups.clear();
+        std::vector<std::unique_ptr<SpillWriter>> writers;
+
+        while(char* row = scan.next()){
+            std::string key = aggregator.groupKey(row);
+            auto itr = groups.find(key);
+            if(itr == groups.end()){
+                if(depth < maxDepth && memoryUsage() >= AGGREGATE_MEMORY_LIMIT){
+                    if(writers.empty() && !openPartitions(writers, fileNames, rowSize, depth)) return false;
+                    writers[partitionOf(key, depth)]->append(row, rowSize);
+                    continue;
+                }
+                itr = groups.emplace(std::move(key), std::vector<AggregateState>(aggregator.columns.size())).first;
+            }
+            aggregator.update(itr->second, row);
+        }
+
+        for(auto& group: groups){
+            if(!emit(group.first, group.second)) return false;
+        }
+        groups.clear();
+        if(writers.empty()) return true;
+
+        for(auto& writer: writers) writer->flushRemaining();
+        bool res = true;
+        for(int32_t i = 0; i < AGGREGATE_PARTITIONS; ++i){
+            if(res){
+                SpillScan partitionScan(fileNames[i], rowSize, spillBlockSize(rowSize, 1));
+                res = run(partitionScan, rowSize, emit, depth + 1);
+            }
+            std::filesystem::remove(fileNames[i]);
+        }
+        return res;
+    }
+
+    static void removeFiles(const std::vector<std::string>& fileNames){
+        std::error_code error;
+        for(auto& fileName: fileNames) std::filesystem::remove(fileName, error);
+    }
+
+    int64_t memoryUsage() const{
+        return groups.size() * aggregator.bytesPerGroup();
+    }
+
+    /// Partitions are named <prefix>_<partition>, see spillFilePrefix
+    bool openPartitions(std::vector<std::unique_ptr<SpillWriter>>& writers, std::vector<std::string>& fileNames,
+                        int32_t rowSize, int32_t depth) const{
+        std::filesystem::create_directories(options.tempDirectory);
+        std::string prefix = spillFilePrefix(options, "agg_" + std::to_string(depth));
+        for(int32_t i = 0; i < AGGREGATE_PARTITIONS; ++i){
+            fileNames.emplace_back(prefix + "_" + std::to_string(i));
+            writers.emplace_back(std::make_unique<SpillWriter>());
+            if(!writers.back()->initialise(fileNames.back().c_str(), spillBlockSize(rowSize, AGGREGATE_PARTITIONS))) return false;
+        }
+        return true;
+    }
+
+    /// Every depth uses a different hash so an overflowing partition is split further
+    static int32_t partitionOf(const std::string& key, int32_t depth){
+        uint64_t hash = std::hash<std::string>{}(key) ^ (0x9e3779b97f4a7c15ULL * (depth + 1));
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash % AGGREGATE_PARTITIONS;
+    }
+};
+
+class SortAggregate{
+public:
+    /// Walks index of group column in key order, a group ends when key changes
+    /// indexOnly => rows are never read, keys of index are enough
+    /// Otherwise every row is fetched and checked against kernels
+    template <typename emit_t>
+    static bool run(Table* table, const Aggregator& aggregator, const KeyRange& range, bool indexOnly,
+                    const std::vector<PredicateKernel>& kernels, const emit_t& emit){
+        BPlusTreeBase* tree = table->index(aggregator.groupIndex);
+        std::vector<AggregateState> states(aggregator.columns.size());
+        std::string currentKey;
+        bool hasGroup = false;
+
+        auto add = [&](const char* row)->bool{
+            std::string key = aggregator.groupKey(row);
+            if(hasGroup && key != currentKey){
+                if(!emit(currentKey, states)) return false;
+                states.assign(aggregator.columns.size(), AggregateState());
+            }
+            if(!hasGroup || key != currentKey) currentKey = std::move(key);
+            hasGroup = true;
+            aggregator.update(states, row);
+            return true;
+        };
+
+        bool res;
+        if(indexOnly){
+            // Key is written into group column of an empty row so aggregator can read it
+            auto row = std::make_unique<char[]>(table->getRowSize());
+            res = tree->rangeScanKeys(range, [&](const std::string& key)->bool{
+                if(!stringToColumn(key, aggregator.groupType, aggregator.groupSize, row.get() + aggregator.groupOffset)) return false;
+                return add(row.get());
+            });
+        }
+        else{
+            res = tree->rangeScan(range, [&](row_t row)->bool{
+                Cursor cursor(table);
+                cursor.row = row;
+                char* buffer = cursor.value();
+                if(buffer == nullptr) return false;
+                for(auto& kernel: kernels){
+                    if(!kernel.matches(buffer)) return true;
+                }
+                return add(buffer);
+            });
+        }
+        if(!res) return false;
+        if(hasGroup) return emit(currentKey, states);
+        return true;
+    }
+};
+
+struct AggregatePlan{
+    AggregateStrategy strategy = AggregateStrategy::hashAggregate;
+    KeyRange range;                 /// Range of group index for sortAggregate
+    bool indexOnly = false;
+    double cost = 0;
+};
+
+class AggregatePlanner{
+public:
+    static AggregatePlan choose(Table* table, const Aggregator& aggregator, SelectStatement* statement){
+        AggregatePlan best;
+        if(statement->selectAllRows && aggregator.groupIndex == -1 && canUseIndexBounds(table, aggregator)){
+            best.strategy = AggregateStrategy::indexBounds;
+            return best;
+        }
+
+        // Hash aggregate scans table once, spilling writes and reads back every row again
+        row_t numRows = table->getNumRows();
+        double dataPages = std::max<double>(1, (table->numSlots() + table->getRowsPerPage() - 1) / table->getRowsPerPage());
+        bool spills = numRows * aggregator.bytesPerGroup() > AGGREGATE_MEMORY_LIMIT;
+        best.cost = dataPages * (spills ? 3 : 1);
+
+        int32_t groupIndex = aggregator.groupIndex;
+        if(groupIndex == -1 || table->index(groupIndex) == nullptr) return best;
+
+        // Sort aggregate reads leaves in order and fetches every row unless keys are enough
+        AggregatePlan plan;
+        plan.strategy = AggregateStrategy::sortAggregate;
+        bool exact = true;
+        if(!statement->selectAllRows){
+            if(statement->condition.col == statement->groupBy){
+                Optimizer::buildRange(statement->condition, plan.range, exact);
+            }
+            else{
+                exact = false;
+            }
+        }
+        // Float keys don't survive conversion to string exactly
+        plan.indexOnly = exact && aggregator.onlyReadsGroup() && aggregator.groupType != DataType::Float;
+
+        IndexStatistics stats = table->index(groupIndex)->statistics();
+        plan.cost = stats.height + stats.leafPages + ((plan.indexOnly || stats.clustered) ? 0 : numRows);
+        if(plan.cost < best.cost) best = plan;
+        return best;
+    }
+
+private:
+    static bool canUseIndexBounds(Table* table, const Aggregator& aggregator){
+        return std::all_of(aggregator.columns.begin(), aggregator.columns.end(), [&](const AggregateColumn& column){
+            if(column.type == AggregateType::count) return true;
+            if(column.type != AggregateType::min && column.type != AggregateType::max) return false;
+            return table->index(column.index) != nullptr;
+        });
+    }
+};
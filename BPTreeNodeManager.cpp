@@ -6,8 +6,8 @@
  * 2. Root Node Page Number     =>  row_t
  * 3. Key size                  =>  int32_t
  * 4. Branching Factor          =>  int32_t
- * 5. Stack Pointer             =>  int32_t
  *
+ * Freed node pages are tracked in <index-file>.fsm
  */
 
 template <typename node_t>
@@ -16,10 +16,8 @@ BPTreeNodeManager<node_t>::BPTreeNodeManager(const char* fileName, int32_t branc
     this->numPages = 0;
     this->branchingFactor = branchingFactor_;
     this->keySize = keySize_;
-    // this->stackPtr = 0;
-    // this->stackPtrOffset = 0;
-    this->stackSize = 0;
-    this->indexStack = nullptr;
+    this->freePages = std::make_unique<FreeSpaceMap>(
+            std::filesystem::path(fileName).replace_extension(".fsm").string());
 
     if(!this->open(fileName)){
         throw std::runtime_error("Unable to Open Table");
@@ -41,13 +39,9 @@ bool BPTreeNodeManager<node_t>::getRoot(){
 
     root = std::make_unique<node_t>();
     // root->isLeaf = true;
-    this->fileLength = static_cast<uint32_t>(lseek(this->fileDescriptor, 0, SEEK_END));
-    this->maxPages = (this->fileLength + PAGE_SIZE - 1) / PAGE_SIZE;
+    this->maxPages = (this->getFileLength() + this->getFrameSize() - 1) / this->getFrameSize();
     if(this->maxPages > rootPageNum){
-        lseek(this->fileDescriptor, rootPageNum * PAGE_SIZE, SEEK_SET);
-        char* buffer = this->root->buffer.get();
-        ssize_t bytesRead = ::read(this->fileDescriptor, buffer, PAGE_SIZE);
-        if(bytesRead == -1){
+        if(!this->readFrame(rootPageNum, this->root->buffer.get())){
             printf("Error reading Root Node: %d\n", errno);
             return false;
         }
@@ -66,13 +60,9 @@ template <typename node_t>
 bool BPTreeNodeManager<node_t>::getHeader(){
     if(this->header != nullptr) return true;
     this->header = std::make_unique<node_t>();
-    this->fileLength = static_cast<uint32_t>(lseek(this->fileDescriptor, 0, SEEK_END));
-    this->maxPages = (this->fileLength + PAGE_SIZE - 1) / PAGE_SIZE;
+    this->maxPages = (this->getFileLength() + this->getFrameSize() - 1) / this->getFrameSize();
     if(this->maxPages > 0){
-        lseek(this->fileDescriptor, 0, SEEK_SET);
-        char* buffer = this->header->buffer.get();
-        ssize_t bytesRead = ::read(this->fileDescriptor, buffer, PAGE_SIZE);
-        if(bytesRead == -1){
+        if(!this->readFrame(0, this->header->buffer.get())){
             printf("Error reading Root Node: %d\n", errno);
             return false;
         }
@@ -97,12 +87,6 @@ void BPTreeNodeManager<node_t>::deserializeHeaderMetaData(){
 
     memcpy(&this->rootPageNum, buffer + offset, sizeof(row_t));
     offset += sizeof(row_t);
-
-    stackSize = (PAGE_SIZE - offset)/sizeof(row_t);
-    indexStack = new(buffer + offset) row_t[stackSize];
-    // memcpy(&this->stackPtr, buffer + offset, sizeof(int32_t));
-    // this->stackPtrOffset = offset;
-    // offset += sizeof(int32_t);
 }
 
 template <typename node_t>
@@ -116,20 +100,10 @@ void BPTreeNodeManager<node_t>::serializeHeaderMetaData(){
 
     memcpy(buffer + offset, &this->rootPageNum, sizeof(row_t));
     offset += sizeof(row_t);
-
-    // this->stackPtrOffset = offset;
-    if(indexStack == nullptr){
-        stackSize = (PAGE_SIZE - offset)/sizeof(row_t);
-        indexStack = new(buffer + offset) row_t[stackSize];
-        indexStack[0] = 0;
-    }
-    // int32_t stackIndex = indexStack == nullptr ? 0 : indexStack[0];
-    // memcpy( buffer + offset, &stackIndex, sizeof(int32_t));
-    // offset += sizeof(int32_t);
 }
 
 template <typename node_t>
-bool BPTreeNodeManager<node_t>::flush(uint32_t pageNum){
+bool BPTreeNodeManager<node_t>::flush(row_t pageNum){
     if(this->fileDescriptor == -1) return false;
     if(pageNum == 0){
         return flushPage(this->header.get());
@@ -149,37 +123,23 @@ bool BPTreeNodeManager<node_t>::flush(uint32_t pageNum){
 template <typename node_t>
 bool BPTreeNodeManager<node_t>::flushAll(){
     base_t::flushAll();
+    freePages->flushAll();
     flushPage(root.get());
     return true;
 }
 
 template <typename node_t>
 bool BPTreeNodeManager<node_t>::flushPage(node_t* node){
-    off_t offset = lseek(this->fileDescriptor, node->pageNum * PAGE_SIZE, SEEK_SET);
-    if (offset == -1) return false;
     if(node->pageNum != 0) node->writeHeader();
-    ssize_t bytesWritten = write(this->fileDescriptor, node->buffer.get(), PAGE_SIZE);
-    if (bytesWritten == -1) return false;
+    if(!this->writeFrame(node->pageNum, node->buffer.get())) return false;
     node->hasUncommitedChanges = false;
     return true;
 }
 
 template <typename node_t>
 row_t BPTreeNodeManager<node_t>::nextFreeIndexLocation(){
-    if(indexStack[0] == 0) return numPages + 1;
-    row_t nextRow = indexStack[indexStack[0]];
-    indexStack[0]--;
-    this->header->hasUncommitedChanges = true;
-    return nextRow;
-//    if(stackPtr == 0) return numPages + 1;
-//    Page* page = this->header.get();
-//    char* buffer = page->buffer.get();
-//    int32_t offset = stackPtrOffset + (stackPtr - 1) * sizeof(row_t) + sizeof(int32_t);
-//    row_t nextRow;
-//    memcpy(&nextRow, buffer + offset, sizeof(row_t));
-//    stackPtr--;
-//    memcpy(buffer, &stackPtr, sizeof(int32_t));
-//    return nextRow;
+    row_t nextPage = freePages->take();
+    return nextPage == -1 ? numPages + 1 : nextPage;
 }
 
 template <typename node_t>
@@ -198,23 +158,7 @@ void BPTreeNodeManager<node_t>::decrementPageNum(){
 
 template <typename node_t>
 void BPTreeNodeManager<node_t>::addFreeIndexLocation(row_t location){
-    ++indexStack[0];
-    if(indexStack[0] >= stackSize){
-        printf("Stack Overflow occurred in main table.\n");
-        throw std::runtime_error("STACK OVERFLOWS HEADER PAGE");
-    }
-    indexStack[indexStack[0]] = location;
-    this->header->hasUncommitedChanges = true;
-
-//    Page* page = this->header.get();
-//    char* buffer = page->buffer.get();
-//    int32_t offset = stackPtrOffset + stackPtr * sizeof(row_t) + sizeof(int32_t);
-//    ++stackPtr;
-//    if(offset + sizeof(row_t) > PAGE_SIZE){
-//        printf("Stack Overflow occurred at %d\n", location);
-//        throw std::runtime_error("STACK OVERFLOWS HEADER PAGE");
-//    }
-//    memcpy(buffer + offset, &location, sizeof(row_t));
+    freePages->add(location);
 }
 
 template<typename node_t>
@@ -253,7 +197,7 @@ void BPTreeNodeManager<node_t>::setRoot(node_t* newNode){
 }
 
 template <typename node_t>
-node_t* BPTreeNodeManager<node_t>::read(int32_t pageNum){
+node_t* BPTreeNodeManager<node_t>::read(row_t pageNum){
     if(pageNum == rootPageNum) return root.get();
     if(pageNum < 0) return nullptr;
     auto node = base_t::read(pageNum, [&](node_t* node){
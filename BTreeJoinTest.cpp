@@ -0,0 +1,74 @@
+#include "HeaderFiles/Table.h"
+#include <filesystem>
+
+/// Merge joins of int indexes where one key repeats over far more leaves than
+/// DEFAULT_PAGE_LIMIT pages, so leaves of the group are evicted while it is joined
+/// 1. Two indexes      => 8000 copies of a key joined with 3
+/// 2. Self join        => An index joined with itself, both sides walk leaves of one cache
+/// Exits with 1 if a pair is missing or repeated. Freed leaves are only caught when built
+/// with AddressSanitizer, see DBMS_TEST_SANITIZE
+/// Index files are written to directory given as argument, removed afterwards
+
+const int32_t duplicates = 8000;
+const int32_t rowsOfOther = 3;
+const int32_t selfDuplicates = 200;
+const int32_t selfDuplicatesAfter = 5;
+
+/// Number of pairs given by merge join of current with other, -1 if join failed
+int64_t joinPairs(BPTree<int>& current, BPTree<int>& other){
+    int64_t pairs = 0;
+    bool res = current.naturalJoinBothIndex(other, [&](row_t rowOfCurrent, row_t rowOfOther)->bool{
+        ++pairs;
+        return true;
+    });
+    return res ? pairs : -1;
+}
+
+bool check(const char* name, int64_t pairs, int64_t expected){
+    if(pairs != expected){
+        printf("%s: merge join gave %lld pairs, expected %lld\n", name, (long long)pairs, (long long)expected);
+        return false;
+    }
+    printf("%s: merge join gave %lld pairs\n", name, (long long)pairs);
+    return true;
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        printf("Usage: %s <directory>\n", argv[0]);
+        return 1;
+    }
+    std::string directory = argv[1];
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    bool res = true;
+    {
+        BPTree<int> current((directory + "/current.idx").c_str(), 2, sizeof(int));
+        BPTree<int> other((directory + "/other.idx").c_str(), 2, sizeof(int));
+
+        // Keys around the group so it starts and ends in the middle of leaves
+        pkey_t pkey = 0;
+        for(int key = 0; key < 10; ++key) current.insert(std::to_string(key), pkey, pkey), ++pkey;
+        for(int i = 0; i < duplicates; ++i) current.insert("10", pkey, pkey), ++pkey;
+        for(int key = 11; key < 20; ++key) current.insert(std::to_string(key), pkey, pkey), ++pkey;
+
+        other.insert("5", 0, 0);
+        for(int i = 1; i <= rowsOfOther; ++i) other.insert("10", i, i);
+        other.insert("15", rowsOfOther + 1, rowsOfOther + 1);
+
+        res &= check("Two indexes", joinPairs(current, other), (int64_t)duplicates * rowsOfOther + 2);
+    }
+    {
+        BPTree<int> self((directory + "/self.idx").c_str(), 2, sizeof(int));
+        pkey_t pkey = 0;
+        self.insert("1", pkey, pkey), ++pkey;
+        for(int i = 0; i < selfDuplicates; ++i) self.insert("7", pkey, pkey), ++pkey;
+        for(int i = 0; i < selfDuplicatesAfter; ++i) self.insert("9", pkey, pkey), ++pkey;
+
+        res &= check("Self join", joinPairs(self, self),
+                     1 + (int64_t)selfDuplicates * selfDuplicates + (int64_t)selfDuplicatesAfter * selfDuplicatesAfter);
+    }
+    std::filesystem::remove_all(directory);
+    return res ? 0 : 1;
+}
@@ -3,12 +3,35 @@
 template <typename key_t> int32_t BPTNode<key_t>::pKeyOffset = P_KEY_OFFSET(sizeof(key_t));
 template <typename key_t> int32_t BPTNode<key_t>::childOffset = CHILD_OFFSET(sizeof(key_t));
 
-// CONVERT TEMPLATE SECIALIZATION
-template <> inline int convertDataType<int>(const std::string& str)    {  return std::stoi(str);  }
-template <> inline char convertDataType<char>(const std::string& str)  {  return str[0];          }
-template <> inline bool convertDataType<bool>(const std::string& str)  {  return str == "true";   }
-template <> inline float convertDataType<float>(const std::string& str){  return std::stof(str);  }
-template <> inline dbms::string convertDataType<dbms::string>(const std::string& str){  return dbms::string(str);  }
+template <typename key_t> inline std::string convertToString(const key_t& key)  {  return std::to_string(key);               }
+template <> inline std::string convertToString<char>(const char& key)           {  return std::string(1, key);              }
+template <> inline std::string convertToString<bool>(const bool& key)           {  return key ? "true" : "false";           }
+template <> inline std::string convertToString<dbms::string>(const dbms::string& key){  return std::string(key.str_, strnlen(key.str_, key.size));  }
+
+template <typename key_t> inline bool convertToNumeric(const key_t& key, double& value)  {  value = static_cast<double>(key); return true;  }
+template <> inline bool convertToNumeric<dbms::string>(const dbms::string& key, double& value)  {  return false;  }
+
+/// Copy of a key that outlives the node page it was read from
+template <typename key_t>
+class KeyCopy{
+    key_t key;
+public:
+    explicit KeyCopy(const key_t& key_): key(key_){}
+    const key_t& get() const{  return key;  }
+};
+
+/// dbms::string only points into its page, so characters are copied to a buffer of its own
+template <>
+class KeyCopy<dbms::string>{
+    std::vector<char> buffer;
+    dbms::string key;
+public:
+    explicit KeyCopy(const dbms::string& key_): buffer(key_.size + 1, 0){
+        key.setBuffer(buffer.data(), key_.size);
+        memcpy(buffer.data(), key_.str_, strnlen(key_.str_, key_.size));
+    }
+    const dbms::string& get() const{  return key;  }
+};
 
 
 template <typename key_t>
@@ -469,7 +492,7 @@ std::pair<key_t,pkey_t> BPTree<key_t>::getMax(Node* node){
 template <typename key_t>
 row_t BPTree<key_t>::deleteAtLeaf(Node* node, int index){
     Node* root = manager.root.get();
-    int res = node->child[index];
+    row_t res = node->child[index];
     if(root->isLeaf && root->size == 1){
         root->size = 0;
         root->hasUncommitedChanges = true;
@@ -683,35 +706,57 @@ void BPTree<key_t>::mergeWithSibling(int indexFound, Node*& parent, Node* child,
 
 // ----------------------- JOIN ----------------------
 template <typename key_t>
-void BPTree<key_t>::naturalJoinBothIndex(Node* rootOfOtherBTree, const std::function<void(row_t rowOfCurrent, row_t rowOfOther)>& funcToPrint){
+bool BPTree<key_t>::naturalJoinBothIndex(BPlusTreeBase& otherBase, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback){
+    auto other = dynamic_cast<BPTree<key_t>*>(&otherBase);
+    if(other == nullptr) return false;
     Node* currentRoot = manager.root.get();
+    Node* otherRoot = other->manager.root.get();
 
     // when either one is empty
-    if(!currentRoot->size || !rootOfOtherBTree->size) return;
+    if(!currentRoot->size || !otherRoot->size) return true;
 
-    Node* leftLeafCurrent = leftMostLeaf(currentRoot);
-    Node* leftLeafOther = leftMostLeaf(rootOfOtherBTree);
+    result_t itrCurrent, itrOther;
+    itrCurrent.node = leftMostLeaf(currentRoot);
+    itrCurrent.index = 0;
+    itrOther.node = other->leftMostLeaf(otherRoot);
+    itrOther.index = 0;
 
-    result_t itrCurrent = {0, leftLeafCurrent}, itrOther = {0, leftLeafOther};
+    std::vector<row_t> groupOfOther;
     while(itrCurrent.node && itrOther.node) {
-        key_t keyOfCurrent = itrCurrent.node->keys[itrCurrent.index];
-        key_t keyOfOther = itrOther.node->keys[itrOther.index];
-        if(keyOfCurrent == keyOfOther){
-            result_t itrTempOther = itrOther;
-            row_t childOfCurrent = itrCurrent.node->child[itrCurrent.index];
-            while(itrTempOther.node && keyOfCurrent == itrTempOther.node->keys[itrTempOther.index]){
-                funcToPrint(childOfCurrent, itrTempOther.node->child[itrTempOther.index]);
-                incrementLinkedList(itrTempOther);
-            }
+        const key_t& keyOfCurrent = itrCurrent.node->keys[itrCurrent.index];
+        const key_t& keyOfOther = itrOther.node->keys[itrOther.index];
+        if(keyOfCurrent < keyOfOther){
             incrementLinkedList(itrCurrent);
         }
-        else if(keyOfCurrent < keyOfOther){
-            incrementLinkedList(itrCurrent);
+        else if(keyOfOther < keyOfCurrent){
+            other->incrementLinkedList(itrOther);
         }
         else {
-            incrementLinkedList(itrOther);
+            // Reading next leaves may evict pages holding key and leaf of either side, so key is
+            // copied and each side's leaf is read again by page number after other side has moved
+            // (other may be this tree)
+            KeyCopy<key_t> groupKey(keyOfCurrent);
+            row_t currentPage = itrCurrent.node->pageNum;
+
+            // Collect all rows of other with this key, then pair them with every row of current with same key
+            groupOfOther.clear();
+            while(itrOther.node && itrOther.node->keys[itrOther.index] == groupKey.get()){
+                groupOfOther.push_back(itrOther.node->child[itrOther.index]);
+                other->incrementLinkedList(itrOther);
+            }
+            row_t otherPage = itrOther.node ? itrOther.node->pageNum : -1;
+
+            itrCurrent.node = manager.read(currentPage);
+            while(itrCurrent.node && itrCurrent.node->keys[itrCurrent.index] == groupKey.get()){
+                for(row_t rowOfOther: groupOfOther){
+                    if(!callback(itrCurrent.node->child[itrCurrent.index], rowOfOther)) return false;
+                }
+                incrementLinkedList(itrCurrent);
+            }
+            if(otherPage != -1) itrOther.node = other->manager.read(otherPage);
         }
     }
+    return true;
 }
 
 template <typename key_t>
@@ -723,11 +768,22 @@ BPTNode<key_t>* BPTree<key_t>::leftMostLeaf(Node* node){
 }
 
 template <typename key_t>
-void BPTree<key_t>::naturalJoinOneIndex(Node* rootOfOtherBTree, const std::function<void(row_t rowOfCurrent, row_t rowOfOther)>& funcToPrint){
-
+BPTNode<key_t>* BPTree<key_t>::rightMostLeaf(Node* node){
+    while(!node->isLeaf){
+        node = node->getChildNode(manager, node->size);
+    }
+    return node;
 }
 
-
+template <typename key_t>
+bool BPTree<key_t>::naturalJoinOneIndex(const std::string& keyOfOther, row_t rowOfOther, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback){
+    KeyRange range;
+    range.hasLow = range.hasHigh = true;
+    range.low = range.high = keyOfOther;
+    return iterateRange(range, [&](Node* node, int index)->bool{
+        return callback(node->child[index], rowOfOther);
+    });
+}
 
 // ----------------------- TRAVERSAL ----------------------
 template <typename key_t>
@@ -740,6 +796,147 @@ bool BPTree<key_t>::traverse(const std::function<bool(row_t row)>& callback){
     return iterateRightLeaf(root,0, callback);
 }
 
+template <typename key_t>
+bool BPTree<key_t>::rangeScan(const KeyRange& range, const std::function<bool(row_t row)>& callback){
+    return iterateRange(range, [&](Node* node, int index)->bool{
+        return callback(node->child[index]);
+    });
+}
+
+template <typename key_t>
+bool BPTree<key_t>::rangeScanKeys(const KeyRange& range, const std::function<bool(const std::string& key)>& callback){
+    return iterateRange(range, [&](Node* node, int index)->bool{
+        return callback(convertToString(node->keys[index]));
+    });
+}
+
+template <typename key_t>
+template <typename callback_t>
+bool BPTree<key_t>::iterateRange(const KeyRange& range, const callback_t& callback){
+    Node* root = manager.root.get();
+    if(root->size == 0) return true;
+
+    key_t low, high;
+    result_t position;
+    if(range.hasLow){
+        low = convertDataType<key_t>(range.low);
+        position = searchUtil(low, -1);
+        if(position.index == position.node->size){
+            position.index--;
+            incrementLinkedList(position);
+        }
+    }
+    else{
+        position.node = leftMostLeaf(root);
+        position.index = 0;
+    }
+    if(range.hasHigh) high = convertDataType<key_t>(range.high);
+
+    while(position.node){
+        auto& key = position.node->keys[position.index];
+        if(range.hasLow && !range.lowInclusive && key == low){
+            incrementLinkedList(position);
+            continue;
+        }
+        if(range.hasHigh && (high < key || (!range.highInclusive && key == high))) break;
+        if(!callback(position.node, position.index)) return false;
+        incrementLinkedList(position);
+    }
+    return true;
+}
+
+template <typename key_t>
+bool BPTree<key_t>::rangeScanReverse(const KeyRange& range, const std::function<bool(row_t row)>& callback){
+    return iterateRangeReverse(range, [&](Node* node, int index)->bool{
+        return callback(node->child[index]);
+    });
+}
+
+template <typename key_t>
+template <typename callback_t>
+bool BPTree<key_t>::iterateRangeReverse(const KeyRange& range, const callback_t& callback){
+    Node* root = manager.root.get();
+    if(root->size == 0) return true;
+
+    key_t low, high;
+    result_t position;
+    if(range.hasHigh){
+        // Position after last entry with key high, then step back once
+        high = convertDataType<key_t>(range.high);
+        position = searchUtil(high, std::numeric_limits<pkey_t>::max());
+        if(position.index == position.node->size) position.index--;
+        else decrementLinkedList(position);
+    }
+    else{
+        position.node = rightMostLeaf(root);
+        position.index = position.node->size - 1;
+    }
+    if(range.hasLow) low = convertDataType<key_t>(range.low);
+
+    while(position.node && position.index >= 0){
+        auto& key = position.node->keys[position.index];
+        if(range.hasHigh && (high < key || (!range.highInclusive && key == high))){
+            decrementLinkedList(position);
+            continue;
+        }
+        if(range.hasLow && (key < low || (!range.lowInclusive && key == low))) break;
+        if(!callback(position.node, position.index)) return false;
+        decrementLinkedList(position);
+    }
+    return true;
+}
+
+template <typename key_t>
+IndexStatistics BPTree<key_t>::statistics(){
+    IndexStatistics stats;
+    Node* root = manager.root.get();
+    stats.numPages = manager.numPages;
+    if(root->size == 0) return stats;
+
+    // Leftmost path gives height and smallest key
+    Node* node = root;
+    stats.height = 1;
+    while(!node->isLeaf){
+        node = node->getChildNode(manager, 0);
+        ++stats.height;
+    }
+    stats.isNumeric = convertToNumeric(node->keys[0], stats.minKey);
+
+    // Rightmost path gives largest key
+    node = rightMostLeaf(root);
+    convertToNumeric(node->keys[node->size - 1], stats.maxKey);
+    stats.hasBounds = stats.isNumeric;
+
+    row_t internalPages = (stats.height > 1) ? std::max<row_t>(1, stats.numPages / branchingFactor) : 0;
+    stats.leafPages = std::max<row_t>(1, stats.numPages - internalPages);
+    return stats;
+}
+
+template <typename key_t>
+bool BPTree<key_t>::firstKey(std::string& key){
+    Node* root = manager.root.get();
+    if(root->size == 0) return false;
+    Node* leaf = leftMostLeaf(root);
+    if(leaf->size == 0) return false;
+    key = convertToString(leaf->keys[0]);
+    return true;
+}
+
+template <typename key_t>
+bool BPTree<key_t>::lastKey(std::string& key){
+    Node* root = manager.root.get();
+    if(root->size == 0) return false;
+    Node* leaf = rightMostLeaf(root);
+    if(leaf->size == 0) return false;
+    key = convertToString(leaf->keys[leaf->size - 1]);
+    return true;
+}
+
+template <typename key_t>
+void BPTree<key_t>::setPageCompression(bool enabled){
+    manager.setPageCompression(enabled);
+}
+
 template <typename key_t>
 bool BPTree<key_t>::BFStraverse(const std::function<bool(row_t row)>& callback){
     return traverseUtil(manager.root.get(), callback);
@@ -794,7 +991,7 @@ void BPTree<key_t>::incrementLinkedList(result_t& currentPosition){
     }
     else {
         if(currentPosition.node->rightSibling_){
-            currentPosition.node = currentPosition.node->rightSibling_;
+            currentPosition.node = currentPosition.node->getRightSibling(manager);
             currentPosition.index = 0;
         }
         else {
@@ -810,9 +1007,10 @@ void BPTree<key_t>::decrementLinkedList(result_t& currentPosition){
         currentPosition.index--;
     }
     else {
-        if(currentPosition.node->leftSibling_){
-            currentPosition.node = currentPosition.node->leftSibling_;
-            currentPosition.index = currentPosition.node->size-1;
+        Node* leftSibling = currentPosition.node->getLeftSibling(manager);
+        if(leftSibling){
+            currentPosition.node = leftSibling;
+            currentPosition.index = leftSibling->size-1;
         }
         else {
             currentPosition.node = nullptr;
@@ -0,0 +1,363 @@
+/// ---------------- CLASS DESCRIPTION ----------------
+/// Batch (vectorized) execution over the row store
+/// BatchScanner copies up to BATCH_SIZE rows into a RowBatch, one memcpy per page range
+/// PredicateKernel filters a whole batch on one fixed width column and narrows its selection vector
+/// On pax pages kernels run on the contiguous values of their column before rows are copied,
+/// so only qualifying rows are assembled (late materialization). On compressed pages they
+/// run on encoded values, see CompressedPage::match
+/// Executor only deserializes rows which are still selected after all kernels ran
+
+#include <algorithm>
+#include <functional>
+
+class RowBatch{
+public:
+    /// Rows copied back to back, rowSize bytes apart
+    std::unique_ptr<char[]> buffer;
+
+    /// Row number (slot in table) of every row in buffer
+    row_t rows[BATCH_SIZE];
+
+    /// Indices into buffer of rows that still qualify
+    int32_t selection[BATCH_SIZE];
+
+    int32_t size;
+    int32_t selected;
+    int32_t rowSize;
+
+    explicit RowBatch(int32_t rowSize_){
+        rowSize = rowSize_;
+        size = 0;
+        selected = 0;
+        buffer = std::make_unique<char[]>(BATCH_SIZE * rowSize);
+    }
+
+    inline char* row(int32_t index){
+        return buffer.get() + index * rowSize;
+    }
+};
+
+class PredicateKernel{
+    DataType type;
+    ComparisonType compType;
+    int32_t column;
+    int32_t offset;
+    int32_t size;
+
+    int32_t intValue{};
+    float floatValue{};
+    char charValue{};
+    bool boolValue{};
+    std::string stringValue;
+
+public:
+    /// Builds kernels for given condition
+    /// Compound condition gives two kernels, on same column or on col and col2
+    /// Returns false if data can't be converted to column type
+    static bool compile(Table* table, const Condition& condition, std::vector<PredicateKernel>& kernels){
+        auto itr = table->columnIndex.find(condition.col);
+        if(itr == table->columnIndex.end()) return false;
+        int32_t index = itr->second;
+
+        kernels.emplace_back();
+        if(!kernels.back().initialise(table, index, condition.compType1, condition.data1)) return false;
+        if(condition.isCompound){
+            auto itr2 = table->columnIndex.find(condition.col2);
+            if(itr2 == table->columnIndex.end()) return false;
+            kernels.emplace_back();
+            if(!kernels.back().initialise(table, itr2->second, condition.compType2, condition.data2)) return false;
+        }
+        return true;
+    }
+
+    /// Narrows selection vector of batch to rows satisfying this predicate
+    /// Only selection entries from `from` onwards are checked, value of batch row index is
+    /// read at values + (index - first) * stride i.e. from batch or straight from a pax page
+    void filter(RowBatch& batch, int32_t from, const char* values, int32_t first, int32_t stride) const{
+        ColumnRange range{from, values, first, stride};
+        switch(type){
+            case DataType::Int:
+                dispatch(batch, range, intValue);
+                break;
+            case DataType::Float:
+                dispatch(batch, range, floatValue);
+                break;
+            case DataType::Char:
+                dispatch(batch, range, charValue);
+                break;
+            case DataType::Bool:
+                dispatch(batch, range, boolValue);
+                break;
+            case DataType::String:
+                filterString(batch, range);
+                break;
+        }
+    }
+
+    /// Narrows selection entries from `from` onwards, batch row index is slot + index - first
+    /// of a compressed page which is not decoded for it
+    void filter(RowBatch& batch, int32_t from, const CompressedPage& compressed, const char* page,
+                int32_t slot, int32_t first) const{
+        uint8_t matches[BATCH_SIZE];
+        compressed.match(page, column, slot, batch.size - first, predicate(), matches);
+        int32_t selected = from;
+        for(int32_t i = from; i < batch.selected; ++i){
+            int32_t index = batch.selection[i];
+            batch.selection[selected] = index;
+            selected += matches[index - first];
+        }
+        batch.selected = selected;
+    }
+
+    /// This predicate on values of its column, int comparisons are also given as a range
+    ColumnPredicate predicate() const{
+        ColumnPredicate predicate;
+        PredicateKernel kernel = *this;
+        predicate.test = [kernel](const char* data){ return kernel.matchesValue(data); };
+        if(type != DataType::Int) return predicate;
+
+        predicate.isRange = true;
+        predicate.low = predicate.high = intValue;
+        switch(compType){
+            case ComparisonType::equal:
+                break;
+            case ComparisonType::notEqual:
+                predicate.negate = true;
+                break;
+            case ComparisonType::lessThan:
+                predicate.low = INT64_MIN;
+                predicate.high = (int64_t)intValue - 1;
+                break;
+            case ComparisonType::greaterThan:
+                predicate.low = (int64_t)intValue + 1;
+                predicate.high = INT64_MAX;
+                break;
+            case ComparisonType::lessThanOrEqual:
+                predicate.low = INT64_MIN;
+                break;
+            case ComparisonType::greaterThanOrEqual:
+                predicate.high = INT64_MAX;
+                break;
+            case ComparisonType::error:
+                predicate.isRange = false;
+                break;
+        }
+        return predicate;
+    }
+
+    int32_t getColumn() const{
+        return column;
+    }
+
+    /// Evaluates this predicate on a single serialized row
+    bool matches(const char* row) const{
+        return matchesValue(row + offset);
+    }
+
+    /// Evaluates this predicate on a value of its column
+    bool matchesValue(const char* data) const{
+        switch(type){
+            case DataType::Int:     return compareFixed(data, intValue);
+            case DataType::Float:   return compareFixed(data, floatValue);
+            case DataType::Char:    return compareFixed(data, charValue);
+            case DataType::Bool:    return compareFixed(data, boolValue);
+            case DataType::String:  return compare(strncmp(data, stringValue.c_str(), size));
+        }
+        return false;
+    }
+
+private:
+    struct ColumnRange{
+        int32_t from;
+        const char* values;
+        int32_t first;
+        int32_t stride;
+    };
+
+    bool initialise(Table* table, int32_t index, ComparisonType compType_, const std::string& data){
+        type = table->columnTypes[index];
+        compType = compType_;
+        column = index;
+        offset = table->columnOffsets[index];
+        size = table->columnSizes[index];
+        if(compType == ComparisonType::error) return false;
+        try{
+            switch(type){
+                case DataType::Int:
+                    intValue = std::stoi(data);
+                    break;
+                case DataType::Float:
+                    floatValue = std::stof(data);
+                    break;
+                case DataType::Char:
+                    if(data.size() != 1) return false;
+                    charValue = data[0];
+                    break;
+                case DataType::Bool:
+                    if(data != "true" && data != "false") return false;
+                    boolValue = (data == "true");
+                    break;
+                case DataType::String:
+                    if(data.size() > size) return false;
+                    stringValue = data;
+                    break;
+            }
+        }
+        catch(...){
+            return false;
+        }
+        return true;
+    }
+
+    /// Comparison is picked once per batch so inner loop stays branch free
+    template <typename T>
+    void dispatch(RowBatch& batch, const ColumnRange& range, const T& value) const{
+        switch(compType){
+            case ComparisonType::equal:
+                filterFixed(batch, range, value, std::equal_to<T>());
+                break;
+            case ComparisonType::notEqual:
+                filterFixed(batch, range, value, std::not_equal_to<T>());
+                break;
+            case ComparisonType::lessThan:
+                filterFixed(batch, range, value, std::less<T>());
+                break;
+            case ComparisonType::greaterThan:
+                filterFixed(batch, range, value, std::greater<T>());
+                break;
+            case ComparisonType::lessThanOrEqual:
+                filterFixed(batch, range, value, std::less_equal<T>());
+                break;
+            case ComparisonType::greaterThanOrEqual:
+                filterFixed(batch, range, value, std::greater_equal<T>());
+                break;
+            case ComparisonType::error:
+                batch.selected = range.from;
+                break;
+        }
+    }
+
+    template <typename T, typename comp_t>
+    void filterFixed(RowBatch& batch, const ColumnRange& range, const T& value, const comp_t& comp) const{
+        const char* values = range.values;
+        const int32_t first = range.first;
+        const int32_t stride = range.stride;
+        int32_t selected = range.from;
+        for(int32_t i = range.from; i < batch.selected; ++i){
+            int32_t index = batch.selection[i];
+            T data;
+            memcpy(&data, values + (index - first) * stride, sizeof(T));
+            batch.selection[selected] = index;
+            selected += comp(data, value);
+        }
+        batch.selected = selected;
+    }
+
+    void filterString(RowBatch& batch, const ColumnRange& range) const{
+        const char* value = stringValue.c_str();
+        int32_t selected = range.from;
+        for(int32_t i = range.from; i < batch.selected; ++i){
+            int32_t index = batch.selection[i];
+            int res = strncmp(range.values + (index - range.first) * range.stride, value, size);
+            batch.selection[selected] = index;
+            selected += compare(res);
+        }
+        batch.selected = selected;
+    }
+
+    template <typename T>
+    inline bool compareFixed(const char* data, const T& value) const{
+        T x;
+        memcpy(&x, data, sizeof(T));
+        return compare((value < x) - (x < value));
+    }
+
+    inline bool compare(int res) const{
+        switch(compType){
+            case ComparisonType::equal:              return res == 0;
+            case ComparisonType::notEqual:           return res != 0;
+            case ComparisonType::lessThan:           return res < 0;
+            case ComparisonType::greaterThan:        return res > 0;
+            case ComparisonType::lessThanOrEqual:    return res <= 0;
+            case ComparisonType::greaterThanOrEqual: return res >= 0;
+            default:                                 return false;
+        }
+    }
+};
+
+class BatchScanner{
+    Table* table;
+    row_t nextRow;
+    row_t numSlots;                     // Used slots in file including deleted ones
+    std::vector<row_t> freeRows;        // Sorted deleted slots
+    std::vector<row_t>::iterator nextFreeRow;
+
+public:
+    explicit BatchScanner(Table* table_){
+        table = table_;
+        nextRow = 0;
+        freeRows = table->freeRowLocations();
+        nextFreeRow = freeRows.begin();
+        numSlots = table->numSlots();
+    }
+
+    /// Fills batch with next rows of table and narrows its selection with kernels
+    /// Deleted slots are left out of selection vector
+    /// Pax pages are filtered on their column values in place, only selected rows are copied
+    /// Returns false when table is exhausted
+    bool next(RowBatch& batch, const std::vector<PredicateKernel>& kernels){
+        batch.size = 0;
+        batch.selected = 0;
+        while(batch.size < BATCH_SIZE && nextRow < numSlots){
+            row_t pageNum = (nextRow / table->rowsPerPage) + 1;
+            Page* page = table->pager->read(pageNum);
+            if(page == nullptr) return false;
+
+            row_t rowInPage = nextRow % table->rowsPerPage;
+            row_t count = std::min<row_t>({table->rowsPerPage - rowInPage, BATCH_SIZE - batch.size, numSlots - nextRow});
+            int32_t first = batch.size;
+            int32_t from = batch.selected;
+            for(row_t i = 0; i < count; ++i){
+                row_t row = nextRow + i;
+                batch.rows[batch.size] = row;
+                while(nextFreeRow != freeRows.end() && *nextFreeRow < row) ++nextFreeRow;
+                bool isFree = (nextFreeRow != freeRows.end() && *nextFreeRow == row);
+                batch.selection[batch.selected] = batch.size;
+                batch.selected += !isFree;
+                ++batch.size;
+            }
+            nextRow += count;
+
+            if(table->layout == TableLayout::pax){
+                const char* buffer = page->buffer.get();
+                for(auto& kernel: kernels){
+                    int32_t size = table->columnSizes[kernel.getColumn()];
+                    const char* values = table->pax->column(buffer, kernel.getColumn()) + rowInPage * size;
+                    kernel.filter(batch, from, values, first, size);
+                }
+                for(int32_t i = from; i < batch.selected; ++i){
+                    int32_t index = batch.selection[i];
+                    table->pax->read(buffer, rowInPage + index - first, batch.row(index));
+                }
+            }
+            else if(table->layout == TableLayout::compressed){
+                const char* buffer = page->buffer.get();
+                for(auto& kernel: kernels){
+                    kernel.filter(batch, from, *table->compressed, buffer, rowInPage, first);
+                }
+                for(int32_t i = from; i < batch.selected; ++i){
+                    int32_t index = batch.selection[i];
+                    table->compressed->read(buffer, rowInPage + index - first, batch.row(index));
+                }
+            }
+            else{
+                memcpy(batch.row(first), table->pageRows(page) + rowInPage * table->rowSize, count * table->rowSize);
+                for(auto& kernel: kernels){
+                    const char* values = batch.row(first) + table->columnOffsets[kernel.getColumn()];
+                    kernel.filter(batch, from, values, first, batch.rowSize);
+                }
+            }
+        }
+        return batch.size > 0;
+    }
+};
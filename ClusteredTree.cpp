@@ -0,0 +1,578 @@
+#include "HeaderFiles/Table.h"
+#include "HeaderFiles/ClusteredTree.h"
+
+// =============================================
+//                  CLUSTERED TREE
+// =============================================
+
+namespace{
+    const int32_t KIND_OFFSET = 0;
+    const int32_t COUNT_OFFSET = sizeof(int32_t);
+    const int32_t NEXT_OFFSET = 2 * sizeof(int32_t);
+    const int32_t PREV_OFFSET = NEXT_OFFSET + sizeof(row_t);
+
+    template <typename T>
+    inline T field(const Page* page, int32_t offset){
+        T value;
+        memcpy(&value, page->buffer.get() + offset, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    inline void setField(Page* page, int32_t offset, T value){
+        memcpy(page->buffer.get() + offset, &value, sizeof(T));
+        page->hasUncommitedChanges = true;
+    }
+
+    /// Writes value given as string in fixed width format of column
+    bool toColumn(const SortColumn& column, const std::string& value, char* out){
+        try{
+            switch(column.type){
+                case DataType::Int: {
+                    int32_t data = std::stoi(value);
+                    memcpy(out, &data, sizeof(int32_t));
+                    break;
+                }
+                case DataType::Float: {
+                    float data = std::stof(value);
+                    memcpy(out, &data, sizeof(float));
+                    break;
+                }
+                case DataType::Char:
+                    out[0] = value.empty() ? '\0' : value[0];
+                    break;
+                case DataType::Bool:
+                    out[0] = (value == "true");
+                    break;
+                case DataType::String:
+                    memset(out, 0, column.size);
+                    memcpy(out, value.data(), std::min<size_t>(strnlen(value.c_str(), value.size()), column.size));
+                    break;
+            }
+        }
+        catch(...){
+            return false;
+        }
+        return true;
+    }
+
+    /// pkey, big endian with sign bit flipped like an int column
+    void encodePkey(pkey_t pkey, char* out){
+        uint64_t bits = (uint64_t)pkey ^ (1ULL << 63);
+        for(int32_t i = sizeof(pkey_t) - 1; i >= 0; --i){
+            out[i] = (char)(bits & 0xFF);
+            bits >>= 8;
+        }
+    }
+
+    bool toNumeric(const SortColumn& column, const char* data, double& value){
+        switch(column.type){
+            case DataType::Int: {
+                int32_t number;
+                memcpy(&number, data, sizeof(int32_t));
+                value = number;
+                return true;
+            }
+            case DataType::Float: {
+                float number;
+                memcpy(&number, data, sizeof(float));
+                value = number;
+                return true;
+            }
+            case DataType::Char:
+                value = data[0];
+                return true;
+            case DataType::Bool:
+                value = data[0] ? 1 : 0;
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+ClusteredTree::ClusteredTree(Pager<Page>* pager_, FreeSpaceMap* freeMap_, RecordFormat format_, row_t root_, row_t numPages_):
+                             format(std::move(format_)), key(format.keyColumns){
+    this->pager = pager_;
+    this->freeMap = freeMap_;
+    this->root = root_;
+    this->numPages = numPages_;
+    int32_t pageSize = pager->getPageSize();
+    this->slots = slotsPerPage(pageSize, format.recordSize);
+    this->dataOffset = recordsOffset(pageSize, format.recordSize);
+    this->keyWidth = key.width + (format.pkeyOffset >= 0 ? (int32_t)sizeof(pkey_t) : 0);
+    this->keySize = keyWidth;
+    this->fanOut = (pageSize - HEADER_SIZE - (int32_t)sizeof(row_t)) / (keyWidth + (int32_t)sizeof(row_t));
+    if(keyWidth == 0) throw std::runtime_error("Clustered tree needs a key");
+    if(slots < 2 || fanOut < 3) throw std::runtime_error("Records or keys too large for a clustered page");
+}
+
+int32_t ClusteredTree::slotsPerPage(int32_t pageSize, int32_t recordSize){
+    // One bit of bitmap per slot, rounded up to whole bytes
+    int32_t count = (int32_t)((int64_t)(pageSize - HEADER_SIZE) * 8 / ((int64_t)recordSize * 8 + 1));
+    while(count > 0 && HEADER_SIZE + (count + 7) / 8 + (int64_t)count * recordSize > pageSize) --count;
+    return count;
+}
+
+int32_t ClusteredTree::recordsOffset(int32_t pageSize, int32_t recordSize){
+    return HEADER_SIZE + (slotsPerPage(pageSize, recordSize) + 7) / 8;
+}
+
+row_t ClusteredTree::getRoot() const{
+    return this->root;
+}
+
+row_t ClusteredTree::getNumPages() const{
+    return this->numPages;
+}
+
+Page* ClusteredTree::page(row_t pageNum){
+    Page* result = pager->read(pageNum);
+    if(result == nullptr) throw std::runtime_error("Error reading clustered page");
+    return result;
+}
+
+/// Appends a page to file, all its slots are free
+row_t ClusteredTree::allocate(PageKind kind){
+    row_t pageNum = ++numPages;
+    Page* result = page(pageNum);
+    memset(result->buffer.get(), 0, pager->getPageSize());
+    setField(result, KIND_OFFSET, kind);
+    if(freeMap != nullptr){
+        for(int32_t slot = 0; slot < slots; ++slot) freeMap->add((pageNum - 1) * slots + slot);
+    }
+    return pageNum;
+}
+
+char* ClusteredTree::recordAt(Page* leaf, int32_t slot) const{
+    return leaf->buffer.get() + dataOffset + (int64_t)slot * format.recordSize;
+}
+
+bool ClusteredTree::isLive(Page* leaf, int32_t slot) const{
+    auto bitmap = reinterpret_cast<const uint8_t*>(leaf->buffer.get() + HEADER_SIZE);
+    return bitmap[slot / 8] & (1u << (slot % 8));
+}
+
+/// Keeps FreeSpaceMap in step with bitmap so that scans skip slots without a live row
+void ClusteredTree::setLive(Page* leaf, int32_t slot, bool live){
+    if(isLive(leaf, slot) == live) return;
+    auto bitmap = reinterpret_cast<uint8_t*>(leaf->buffer.get() + HEADER_SIZE);
+    bitmap[slot / 8] ^= (1u << (slot % 8));
+    leaf->hasUncommitedChanges = true;
+    if(freeMap == nullptr) return;
+    row_t row = (leaf->pageNum - 1) * slots + slot;
+    if(live) freeMap->remove(row);
+    else freeMap->add(row);
+}
+
+row_t ClusteredTree::rowOf(row_t pageNum, int32_t slot, const char* record) const{
+    if(format.rowOffset < 0) return (pageNum - 1) * slots + slot;
+    row_t row;
+    memcpy(&row, record + format.rowOffset, sizeof(row_t));
+    return row;
+}
+
+void ClusteredTree::encodeKey(const char* record, char* out) const{
+    key.encode(record, out);
+    if(format.pkeyOffset < 0) return;
+    pkey_t pkey;
+    memcpy(&pkey, record + format.pkeyOffset, sizeof(pkey_t));
+    encodePkey(pkey, out + key.width);
+}
+
+/// Encodes value of key column, column after last one is pkey if it is part of key
+/// Returns width of encoded value, -1 if value doesn't fit type
+int32_t ClusteredTree::encodeBound(size_t column, const std::string& value, char* out) const{
+    if(column == key.columns.size() && format.pkeyOffset >= 0){
+        try{
+            encodePkey(std::stoll(value), out);
+        }
+        catch(...){
+            return -1;
+        }
+        return sizeof(pkey_t);
+    }
+    if(column >= key.columns.size()) return -1;
+    std::vector<char> data(key.columns[column].size);
+    if(!toColumn(key.columns[column], value, data.data())) return -1;
+    key.encodeValue(column, data.data(), out);
+    return key.columns[column].size;
+}
+
+// ----------------------- SEARCH ----------------------
+
+/// Leaf holding first record whose key prefix of width is >= searchKey, or last one <= searchKey if upper
+/// Internal pages taken are added to path with index of child, if given
+row_t ClusteredTree::findLeaf(const char* searchKey, int32_t width, bool upper, std::vector<std::pair<row_t, int32_t>>* path){
+    row_t pageNum = root;
+    const int32_t entrySize = keyWidth + sizeof(row_t);
+    while(true){
+        Page* node = page(pageNum);
+        if(field<PageKind>(node, KIND_OFFSET) != PageKind::internal) return pageNum;
+
+        // Keys of child i are >= key i - 1, so take child after last key below searchKey
+        int32_t low = 0, high = field<int32_t>(node, COUNT_OFFSET);
+        const char* entries = node->buffer.get() + HEADER_SIZE + sizeof(row_t);
+        while(low < high){
+            int32_t mid = (low + high) / 2;
+            int cmp = memcmp(entries + (int64_t)mid * entrySize, searchKey, width);
+            if(cmp < 0 || (upper && cmp == 0)) low = mid + 1;
+            else high = mid;
+        }
+        if(path != nullptr) path->emplace_back(pageNum, low);
+        pageNum = (low == 0) ? field<row_t>(node, HEADER_SIZE)
+                             : field<row_t>(node, HEADER_SIZE + sizeof(row_t) + (low - 1) * entrySize + keyWidth);
+    }
+}
+
+row_t ClusteredTree::edgeLeaf(bool rightmost){
+    row_t pageNum = root;
+    const int32_t entrySize = keyWidth + sizeof(row_t);
+    while(true){
+        Page* node = page(pageNum);
+        if(field<PageKind>(node, KIND_OFFSET) != PageKind::internal) return pageNum;
+        int32_t count = field<int32_t>(node, COUNT_OFFSET);
+        pageNum = (!rightmost || count == 0) ? field<row_t>(node, HEADER_SIZE)
+                                             : field<row_t>(node, HEADER_SIZE + sizeof(row_t) + (count - 1) * entrySize + keyWidth);
+    }
+}
+
+/// First slot of leaf with key prefix >= searchKey, or > searchKey if upper. Holes keep their records so order holds
+int32_t ClusteredTree::lowerBound(Page* leaf, const char* searchKey, int32_t width, bool upper){
+    std::vector<char> slotKey(keyWidth);
+    int32_t low = 0, high = field<int32_t>(leaf, COUNT_OFFSET);
+    while(low < high){
+        int32_t mid = (low + high) / 2;
+        encodeKey(recordAt(leaf, mid), slotKey.data());
+        int cmp = memcmp(slotKey.data(), searchKey, width);
+        if(cmp < 0 || (upper && cmp == 0)) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// ----------------------- INSERTION ----------------------
+
+row_t ClusteredTree::insert(const char* record){
+    std::vector<char> recordKey(keyWidth);
+    encodeKey(record, recordKey.data());
+    if(root == 0) root = allocate(PageKind::leaf);
+
+    // Internal pages on path to leaf with index of child taken in each
+    std::vector<std::pair<row_t, int32_t>> path;
+    row_t pageNum = findLeaf(recordKey.data(), keyWidth, true, &path);
+
+    Page* leaf = page(pageNum);
+    compact(leaf);
+    int32_t count = field<int32_t>(leaf, COUNT_OFFSET);
+    int32_t slot = lowerBound(leaf, recordKey.data(), keyWidth, false);
+    if(slot < count){
+        std::vector<char> slotKey(keyWidth);
+        encodeKey(recordAt(leaf, slot), slotKey.data());
+        if(memcmp(slotKey.data(), recordKey.data(), keyWidth) == 0) return -1;
+    }
+    if(count < slots){
+        insertAt(leaf, slot, record);
+        return (pageNum - 1) * slots + slot;
+    }
+
+    // Split. Appending past last leaf starts an empty leaf so that ascending inserts fill pages
+    row_t rightNum = allocate(PageKind::leaf);
+    leaf = page(pageNum);
+    Page* right = page(rightNum);
+    row_t nextNum = field<row_t>(leaf, NEXT_OFFSET);
+    int32_t splitAt = (slot == count && nextNum == 0) ? count : count / 2;
+    memcpy(recordAt(right, 0), recordAt(leaf, splitAt), (int64_t)(count - splitAt) * format.recordSize);
+    for(int32_t i = splitAt; i < count; ++i){
+        setLive(right, i - splitAt, true);
+        setLive(leaf, i, false);
+    }
+    setField<int32_t>(right, COUNT_OFFSET, count - splitAt);
+    setField<int32_t>(leaf, COUNT_OFFSET, splitAt);
+    setField<row_t>(right, NEXT_OFFSET, nextNum);
+    setField<row_t>(right, PREV_OFFSET, pageNum);
+    setField<row_t>(leaf, NEXT_OFFSET, rightNum);
+    if(nextNum != 0) setField<row_t>(page(nextNum), PREV_OFFSET, rightNum);
+
+    row_t inserted;
+    if(slot >= splitAt){
+        right = page(rightNum);
+        insertAt(right, slot - splitAt, record);
+        inserted = (rightNum - 1) * slots + slot - splitAt;
+    }
+    else{
+        leaf = page(pageNum);
+        insertAt(leaf, slot, record);
+        inserted = (pageNum - 1) * slots + slot;
+    }
+
+    std::vector<char> separator(keyWidth);
+    encodeKey(recordAt(page(rightNum), 0), separator.data());
+    insertIntoParent(path, std::move(separator), rightNum);
+    return inserted;
+}
+
+/// Moves live records of leaf to its front, in key order
+void ClusteredTree::compact(Page* leaf){
+    int32_t count = field<int32_t>(leaf, COUNT_OFFSET);
+    int32_t live = 0;
+    for(int32_t slot = 0; slot < count; ++slot){
+        if(!isLive(leaf, slot)) continue;
+        if(slot != live) memcpy(recordAt(leaf, live), recordAt(leaf, slot), format.recordSize);
+        ++live;
+    }
+    if(live == count) return;
+    for(int32_t slot = 0; slot < count; ++slot) setLive(leaf, slot, slot < live);
+    setField<int32_t>(leaf, COUNT_OFFSET, live);
+}
+
+/// Shifts records from slot one place right, leaf must have no holes and a free slot
+void ClusteredTree::insertAt(Page* leaf, int32_t slot, const char* record){
+    int32_t count = field<int32_t>(leaf, COUNT_OFFSET);
+    memmove(recordAt(leaf, slot + 1), recordAt(leaf, slot), (int64_t)(count - slot) * format.recordSize);
+    memcpy(recordAt(leaf, slot), record, format.recordSize);
+    setLive(leaf, count, true);
+    setField<int32_t>(leaf, COUNT_OFFSET, count + 1);
+}
+
+/// Adds (separator, child) after child taken at end of path, splitting internal pages up to root
+void ClusteredTree::insertIntoParent(std::vector<std::pair<row_t, int32_t>>& path, std::vector<char> separator, row_t child){
+    const int32_t entrySize = keyWidth + sizeof(row_t);
+    const int32_t entriesOffset = HEADER_SIZE + sizeof(row_t);
+    std::vector<char> entry(entrySize);
+    while(true){
+        if(path.empty()){
+            row_t newRoot = allocate(PageKind::internal);
+            Page* node = page(newRoot);
+            setField<row_t>(node, HEADER_SIZE, root);
+            memcpy(node->buffer.get() + entriesOffset, separator.data(), keyWidth);
+            setField<row_t>(node, entriesOffset + keyWidth, child);
+            setField<int32_t>(node, COUNT_OFFSET, 1);
+            root = newRoot;
+            return;
+        }
+        auto [parentNum, index] = path.back();
+        path.pop_back();
+        memcpy(entry.data(), separator.data(), keyWidth);
+        memcpy(entry.data() + keyWidth, &child, sizeof(row_t));
+
+        Page* parent = page(parentNum);
+        int32_t count = field<int32_t>(parent, COUNT_OFFSET);
+        char* entries = parent->buffer.get() + entriesOffset;
+        if(count < fanOut){
+            memmove(entries + (int64_t)(index + 1) * entrySize, entries + (int64_t)index * entrySize, (int64_t)(count - index) * entrySize);
+            memcpy(entries + (int64_t)index * entrySize, entry.data(), entrySize);
+            setField<int32_t>(parent, COUNT_OFFSET, count + 1);
+            return;
+        }
+
+        // Entries with new one in place, middle key moves up and its child starts right page
+        std::vector<char> all((int64_t)(count + 1) * entrySize);
+        memcpy(all.data(), entries, (int64_t)index * entrySize);
+        memcpy(all.data() + (int64_t)index * entrySize, entry.data(), entrySize);
+        memcpy(all.data() + (int64_t)(index + 1) * entrySize, entries + (int64_t)index * entrySize, (int64_t)(count - index) * entrySize);
+        int32_t middle = (count + 1) / 2;
+        const char* promoted = all.data() + (int64_t)middle * entrySize;
+
+        row_t rightNum = allocate(PageKind::internal);
+        parent = page(parentNum);
+        Page* right = page(rightNum);
+        memcpy(parent->buffer.get() + entriesOffset, all.data(), (int64_t)middle * entrySize);
+        setField<int32_t>(parent, COUNT_OFFSET, middle);
+        memcpy(right->buffer.get() + HEADER_SIZE, promoted + keyWidth, sizeof(row_t));
+        memcpy(right->buffer.get() + entriesOffset, promoted + entrySize, (int64_t)(count - middle) * entrySize);
+        setField<int32_t>(right, COUNT_OFFSET, count - middle);
+
+        memcpy(separator.data(), promoted, keyWidth);
+        child = rightNum;
+    }
+}
+
+void ClusteredTree::erase(row_t row){
+    Page* leaf = page(row / slots + 1);
+    auto bitmap = reinterpret_cast<uint8_t*>(leaf->buffer.get() + HEADER_SIZE);
+    int32_t slot = row % slots;
+    bitmap[slot / 8] &= ~(1u << (slot % 8));
+    leaf->hasUncommitedChanges = true;
+}
+
+bool ClusteredTree::remove(const char* record){
+    if(root == 0) return false;
+    std::vector<char> recordKey(keyWidth), slotKey(keyWidth);
+    encodeKey(record, recordKey.data());
+    Page* leaf = page(findLeaf(recordKey.data(), keyWidth, true));
+    int32_t slot = lowerBound(leaf, recordKey.data(), keyWidth, false);
+    if(slot >= field<int32_t>(leaf, COUNT_OFFSET) || !isLive(leaf, slot)) return false;
+    encodeKey(recordAt(leaf, slot), slotKey.data());
+    if(memcmp(slotKey.data(), recordKey.data(), keyWidth) != 0) return false;
+    setLive(leaf, slot, false);
+    return true;
+}
+
+// ----------------------- TRAVERSAL ----------------------
+
+bool ClusteredTree::scan(const KeyRange& range, bool reverse, const std::function<bool(row_t row, const char* record)>& callback){
+    if(root == 0) return true;
+
+    // Bounds are key prefixes, fixed leading columns then bound on next column
+    std::vector<char> low(keyWidth), high(keyWidth), slotKey(keyWidth);
+    int32_t prefixWidth = 0;
+    for(size_t i = 0; i < range.prefix.size(); ++i){
+        int32_t width = encodeBound(i, range.prefix[i], low.data() + prefixWidth);
+        if(width < 0) return false;
+        prefixWidth += width;
+    }
+    memcpy(high.data(), low.data(), prefixWidth);
+    int32_t lowWidth = prefixWidth, highWidth = prefixWidth;
+    if(range.hasLow){
+        int32_t width = encodeBound(range.prefix.size(), range.low, low.data() + prefixWidth);
+        if(width < 0) return false;
+        lowWidth += width;
+    }
+    if(range.hasHigh){
+        int32_t width = encodeBound(range.prefix.size(), range.high, high.data() + prefixWidth);
+        if(width < 0) return false;
+        highWidth += width;
+    }
+    bool hasLow = lowWidth > 0, hasHigh = highWidth > 0;
+    bool lowInclusive = !range.hasLow || range.lowInclusive;
+    bool highInclusive = !range.hasHigh || range.highInclusive;
+
+    // Start at first slot in range, or last one when reversed
+    const std::vector<char>& start = reverse ? high : low;
+    int32_t startWidth = reverse ? highWidth : lowWidth;
+    bool bounded = reverse ? hasHigh : hasLow;
+    row_t pageNum = bounded ? findLeaf(start.data(), startWidth, reverse) : edgeLeaf(reverse);
+    int32_t slot;
+    if(bounded) slot = lowerBound(page(pageNum), start.data(), startWidth, reverse) - (reverse ? 1 : 0);
+    else slot = reverse ? field<int32_t>(page(pageNum), COUNT_OFFSET) - 1 : 0;
+
+    while(pageNum != 0){
+        int32_t count = field<int32_t>(page(pageNum), COUNT_OFFSET);
+        for(; slot >= 0 && slot < count; slot += reverse ? -1 : 1){
+            // Page is read again as callback may read other pages
+            Page* leaf = page(pageNum);
+            if(!isLive(leaf, slot)) continue;
+            const char* record = recordAt(leaf, slot);
+            encodeKey(record, slotKey.data());
+            if(hasLow){
+                int cmp = memcmp(slotKey.data(), low.data(), lowWidth);
+                if(cmp < 0 || (cmp == 0 && !lowInclusive)){
+                    if(reverse) return true;
+                    continue;
+                }
+            }
+            if(hasHigh){
+                int cmp = memcmp(slotKey.data(), high.data(), highWidth);
+                if(cmp > 0 || (cmp == 0 && !highInclusive)){
+                    if(!reverse) return true;
+                    continue;
+                }
+            }
+            if(!callback(rowOf(pageNum, slot, record), record)) return false;
+        }
+        pageNum = field<row_t>(page(pageNum), reverse ? PREV_OFFSET : NEXT_OFFSET);
+        slot = (reverse && pageNum != 0) ? field<int32_t>(page(pageNum), COUNT_OFFSET) - 1 : 0;
+    }
+    return true;
+}
+
+bool ClusteredTree::traverse(const std::function<bool(row_t row)>& callback){
+    return rangeScan(KeyRange(), callback);
+}
+
+bool ClusteredTree::rangeScan(const KeyRange& range, const std::function<bool(row_t row)>& callback){
+    return scan(range, false, [&](row_t row, const char* record)->bool{
+        return callback(row);
+    });
+}
+
+bool ClusteredTree::rangeScanKeys(const KeyRange& range, const std::function<bool(const std::string& key)>& callback){
+    if(key.columns.empty()) return false;
+    std::vector<char> recordKey(keyWidth);
+    return scan(range, false, [&](row_t row, const char* record)->bool{
+        encodeKey(record, recordKey.data());
+        return callback(key.decode(recordKey.data())[0]);
+    });
+}
+
+bool ClusteredTree::rangeScanReverse(const KeyRange& range, const std::function<bool(row_t row)>& callback){
+    return scan(range, true, [&](row_t row, const char* record)->bool{
+        return callback(row);
+    });
+}
+
+bool ClusteredTree::covers(int32_t column){
+    return format.rowOffset < 0;
+}
+
+bool ClusteredTree::rangeScanCovered(const KeyRange& range, const std::function<bool(char* row)>& callback){
+    if(format.rowOffset >= 0) return false;
+    std::vector<char> row(format.recordSize);
+    return scan(range, false, [&](row_t rowNum, const char* record)->bool{
+        memcpy(row.data(), record, format.recordSize);
+        return callback(row.data());
+    });
+}
+
+bool ClusteredTree::naturalJoinOneIndex(const std::string& keyOfOther, row_t rowOfOther, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback){
+    KeyRange range;
+    range.hasLow = range.hasHigh = true;
+    range.low = range.high = keyOfOther;
+    return rangeScan(range, [&](row_t row)->bool{
+        return callback(row, rowOfOther);
+    });
+}
+
+/// Value of first key column in first or last live record
+bool ClusteredTree::edgeKey(bool last, std::string& value){
+    if(key.columns.empty()) return false;
+    std::vector<char> recordKey(keyWidth);
+    bool found = false;
+    scan(KeyRange(), last, [&](row_t row, const char* record)->bool{
+        encodeKey(record, recordKey.data());
+        value = key.decode(recordKey.data())[0];
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+bool ClusteredTree::firstKey(std::string& value){
+    return edgeKey(false, value);
+}
+
+bool ClusteredTree::lastKey(std::string& value){
+    return edgeKey(true, value);
+}
+
+IndexStatistics ClusteredTree::statistics(){
+    IndexStatistics stats;
+    stats.clustered = format.rowOffset < 0;
+    stats.numPages = numPages;
+    if(root == 0) return stats;
+
+    row_t pageNum = root;
+    stats.height = 1;
+    while(field<PageKind>(page(pageNum), KIND_OFFSET) == PageKind::internal){
+        pageNum = field<row_t>(page(pageNum), HEADER_SIZE);
+        ++stats.height;
+    }
+    row_t internalPages = (stats.height > 1) ? std::max<row_t>(1, numPages / fanOut) : 0;
+    stats.leafPages = std::max<row_t>(1, numPages - internalPages);
+
+    if(key.columns.empty()) return stats;
+    const SortColumn& column = key.columns[0];
+    bool hasMin = false, hasMax = false;
+    scan(KeyRange(), false, [&](row_t row, const char* record)->bool{
+        hasMin = toNumeric(column, record + column.offset, stats.minKey);
+        return false;
+    });
+    scan(KeyRange(), true, [&](row_t row, const char* record)->bool{
+        hasMax = toNumeric(column, record + column.offset, stats.maxKey);
+        return false;
+    });
+    stats.isNumeric = hasMin && hasMax;
+    stats.hasBounds = stats.isNumeric;
+    return stats;
+}
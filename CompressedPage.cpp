@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include "HeaderFiles/CompressedPage.h"
+
+// =============================================
+//                  COMPRESSED PAGE
+// =============================================
+//
+// dictionary        =>  int32_t count, count x int32_t end of entry, entry bytes, uint8_t code per slot
+// runLength         =>  int32_t runs, runs x (int32_t end slot of run, value)
+// frameOfReference  =>  int64_t minimum, int32_t bit width, offsets bit packed in uint64_t words
+
+namespace{
+    inline int64_t loadInt(const char* data, uint32_t size){
+        if(size == sizeof(int64_t)){
+            int64_t value;
+            memcpy(&value, data, sizeof(int64_t));
+            return value;
+        }
+        int32_t value;
+        memcpy(&value, data, sizeof(int32_t));
+        return value;
+    }
+
+    inline void storeInt(char* data, uint32_t size, int64_t value){
+        if(size == sizeof(int64_t)){
+            memcpy(data, &value, sizeof(int64_t));
+            return;
+        }
+        auto narrow = (int32_t)value;
+        memcpy(data, &narrow, sizeof(int32_t));
+    }
+
+    inline int32_t loadInt32(const char* data){
+        int32_t value;
+        memcpy(&value, data, sizeof(int32_t));
+        return value;
+    }
+
+    inline uint64_t unpack(const char* words, int64_t index, int32_t width){
+        if(width == 0) return 0;
+        int64_t bit = index * width;
+        uint64_t low, high = 0;
+        memcpy(&low, words + (bit / 64) * sizeof(uint64_t), sizeof(uint64_t));
+        int32_t shift = bit % 64;
+        uint64_t value = low >> shift;
+        if(shift + width > 64){
+            memcpy(&high, words + (bit / 64 + 1) * sizeof(uint64_t), sizeof(uint64_t));
+            value |= high << (64 - shift);
+        }
+        return value & ((1ULL << width) - 1);
+    }
+
+    inline int32_t packedSize(int64_t count, int32_t width){
+        return (int32_t)((count * width + 63) / 64 * sizeof(uint64_t));
+    }
+
+    /// Index of run holding slot, runs are sorted by end slot
+    inline int32_t findRun(const char* runs, int32_t numRuns, int32_t runSize, int32_t slot){
+        int32_t low = 0, high = numRuns - 1;
+        while(low < high){
+            int32_t mid = (low + high) / 2;
+            if(loadInt32(runs + mid * runSize) > slot) high = mid;
+            else low = mid + 1;
+        }
+        return low;
+    }
+}
+
+CompressedPage::CompressedPage(const std::vector<DataType>& columnTypes, const std::vector<uint32_t>& columnSizes,
+                               int32_t pageSize_){
+    pageSize = pageSize_;
+    fieldTypes = columnTypes;
+    fieldTypes.push_back(DataType::Int);
+    fieldSizes = columnSizes;
+    fieldSizes.push_back(sizeof(pkey_t));
+    rowSize = 0;
+    for(uint32_t size: fieldSizes){
+        fieldOffsets.push_back(rowSize);
+        rowSize += size;
+    }
+    // Plain encoding of every field must still fit in a page
+    headerSize = (int32_t)fieldSizes.size() * FIELD_HEADER_SIZE;
+    numSlots = std::max((pageSize - headerSize) / rowSize, 1);
+}
+
+int32_t CompressedPage::slotsPerPage() const{
+    return numSlots;
+}
+
+ColumnEncoding CompressedPage::encoding(const char* page, int32_t field) const{
+    ColumnEncoding encoding;
+    memcpy(&encoding, page + field * FIELD_HEADER_SIZE, sizeof(ColumnEncoding));
+    return encoding;
+}
+
+/// nullptr if page was never written
+const char* CompressedPage::fieldData(const char* page, int32_t field) const{
+    int32_t offset = loadInt32(page + field * FIELD_HEADER_SIZE + sizeof(int32_t));
+    return offset == 0 ? nullptr : page + offset;
+}
+
+void CompressedPage::compress(const char* rows, char* page) const{
+    int32_t offset = headerSize;
+    for(size_t field = 0; field < fieldSizes.size(); ++field){
+        ColumnEncoding encoding;
+        int32_t length = encodeField(rows, field, page + offset, encoding);
+        memcpy(page + field * FIELD_HEADER_SIZE, &encoding, sizeof(ColumnEncoding));
+        memcpy(page + field * FIELD_HEADER_SIZE + sizeof(int32_t), &offset, sizeof(int32_t));
+        offset += length;
+    }
+    memset(page + offset, 0, pageSize - offset);
+}
+
+/// Picks smallest encoding of field for values in rows, writes it to out and returns its length
+int32_t CompressedPage::encodeField(const char* rows, int32_t field, char* out, ColumnEncoding& encoding) const{
+    const uint32_t size = fieldSizes[field];
+    const char* values = rows + fieldOffsets[field];
+    auto value = [&](int32_t slot){ return values + (int64_t)slot * rowSize; };
+
+    encoding = ColumnEncoding::plain;
+    int32_t best = numSlots * size;
+
+    std::map<std::string, int32_t> dictionary;
+    int32_t numRuns = 0;
+    int64_t minimum = 0, maximum = 0;
+    int32_t width = 0;
+
+    switch(fieldTypes[field]){
+        case DataType::String: {
+            int32_t entryBytes = 0;
+            for(int32_t slot = 0; slot < numSlots && (int32_t)dictionary.size() <= MAX_DICTIONARY_SIZE; ++slot){
+                auto inserted = dictionary.emplace(std::string(value(slot), strnlen(value(slot), size)), 0);
+                if(inserted.second) entryBytes += inserted.first->first.size();
+            }
+            auto count = (int32_t)dictionary.size();
+            int32_t length = sizeof(int32_t) * (1 + count) + entryBytes + numSlots;
+            if(count <= MAX_DICTIONARY_SIZE && length < best){
+                encoding = ColumnEncoding::dictionary;
+                best = length;
+            }
+            break;
+        }
+        case DataType::Bool:
+        case DataType::Char: {
+            for(int32_t slot = 0; slot < numSlots; ++slot){
+                if(slot == 0 || memcmp(value(slot), value(slot - 1), size) != 0) ++numRuns;
+            }
+            int32_t length = sizeof(int32_t) + numRuns * (sizeof(int32_t) + size);
+            if(length < best){
+                encoding = ColumnEncoding::runLength;
+                best = length;
+            }
+            break;
+        }
+        case DataType::Int: {
+            minimum = maximum = loadInt(value(0), size);
+            for(int32_t slot = 1; slot < numSlots; ++slot){
+                int64_t x = loadInt(value(slot), size);
+                minimum = std::min(minimum, x);
+                maximum = std::max(maximum, x);
+            }
+            auto range = (uint64_t)(maximum - minimum);
+            width = range == 0 ? 0 : 64 - __builtin_clzll(range);
+            int32_t length = sizeof(int64_t) + sizeof(int32_t) + packedSize(numSlots, width);
+            if(width <= 32 && length < best){
+                encoding = ColumnEncoding::frameOfReference;
+                best = length;
+            }
+            break;
+        }
+        case DataType::Float:
+            break;
+    }
+
+    switch(encoding){
+        case ColumnEncoding::plain:
+            for(int32_t slot = 0; slot < numSlots; ++slot) memcpy(out + (int64_t)slot * size, value(slot), size);
+            break;
+
+        case ColumnEncoding::dictionary: {
+            auto count = (int32_t)dictionary.size();
+            memcpy(out, &count, sizeof(int32_t));
+            char* entries = out + sizeof(int32_t) * (1 + count);
+            int32_t end = 0, code = 0;
+            for(auto& entry: dictionary){
+                entry.second = code;
+                memcpy(entries + end, entry.first.data(), entry.first.size());
+                end += entry.first.size();
+                memcpy(out + sizeof(int32_t) * (1 + code), &end, sizeof(int32_t));
+                ++code;
+            }
+            char* codes = entries + end;
+            for(int32_t slot = 0; slot < numSlots; ++slot){
+                codes[slot] = (char)dictionary[std::string(value(slot), strnlen(value(slot), size))];
+            }
+            break;
+        }
+
+        case ColumnEncoding::runLength: {
+            memcpy(out, &numRuns, sizeof(int32_t));
+            char* run = out + sizeof(int32_t);
+            for(int32_t slot = 0; slot < numSlots; ++slot){
+                bool last = (slot + 1 == numSlots) || memcmp(value(slot), value(slot + 1), size) != 0;
+                if(!last) continue;
+                int32_t end = slot + 1;
+                memcpy(run, &end, sizeof(int32_t));
+                memcpy(run + sizeof(int32_t), value(slot), size);
+                run += sizeof(int32_t) + size;
+            }
+            break;
+        }
+
+        case ColumnEncoding::frameOfReference: {
+            memcpy(out, &minimum, sizeof(int64_t));
+            memcpy(out + sizeof(int64_t), &width, sizeof(int32_t));
+            char* words = out + sizeof(int64_t) + sizeof(int32_t);
+            memset(words, 0, packedSize(numSlots, width));
+            if(width == 0) break;
+            for(int32_t slot = 0; slot < numSlots; ++slot){
+                auto offset = (uint64_t)(loadInt(value(slot), size) - minimum);
+                int64_t bit = (int64_t)slot * width;
+                char* word = words + (bit / 64) * sizeof(uint64_t);
+                uint64_t low;
+                memcpy(&low, word, sizeof(uint64_t));
+                low |= offset << (bit % 64);
+                memcpy(word, &low, sizeof(uint64_t));
+                if(bit % 64 + width > 64){
+                    uint64_t high;
+                    memcpy(&high, word + sizeof(uint64_t), sizeof(uint64_t));
+                    high |= offset >> (64 - bit % 64);
+                    memcpy(word + sizeof(uint64_t), &high, sizeof(uint64_t));
+                }
+            }
+            break;
+        }
+    }
+    return best;
+}
+
+/// Decodes field of slots [from, from + count) into rows starting at rows
+void CompressedPage::decodeField(const char* page, int32_t field, int32_t from, int32_t count, char* rows) const{
+    const uint32_t size = fieldSizes[field];
+    char* values = rows + fieldOffsets[field];
+    auto value = [&](int32_t i){ return values + (int64_t)i * rowSize; };
+    const char* data = fieldData(page, field);
+    if(data == nullptr){
+        for(int32_t i = 0; i < count; ++i) memset(value(i), 0, size);
+        return;
+    }
+
+    switch(encoding(page, field)){
+        case ColumnEncoding::plain:
+            for(int32_t i = 0; i < count; ++i) memcpy(value(i), data + (int64_t)(from + i) * size, size);
+            break;
+
+        case ColumnEncoding::dictionary: {
+            int32_t entries = loadInt32(data);
+            const char* bytes = data + sizeof(int32_t) * (1 + entries);
+            const char* codes = bytes + loadInt32(data + sizeof(int32_t) * entries);
+            for(int32_t i = 0; i < count; ++i){
+                auto code = (uint8_t)codes[from + i];
+                int32_t start = code == 0 ? 0 : loadInt32(data + sizeof(int32_t) * code);
+                int32_t end = loadInt32(data + sizeof(int32_t) * (code + 1));
+                memcpy(value(i), bytes + start, end - start);
+                memset(value(i) + end - start, 0, size - (end - start));
+            }
+            break;
+        }
+
+        case ColumnEncoding::runLength: {
+            const int32_t runSize = sizeof(int32_t) + size;
+            const char* runs = data + sizeof(int32_t);
+            int32_t run = findRun(runs, loadInt32(data), runSize, from);
+            for(int32_t i = 0; i < count; ++i){
+                while(loadInt32(runs + run * runSize) <= from + i) ++run;
+                memcpy(value(i), runs + run * runSize + sizeof(int32_t), size);
+            }
+            break;
+        }
+
+        case ColumnEncoding::frameOfReference: {
+            int64_t minimum;
+            memcpy(&minimum, data, sizeof(int64_t));
+            int32_t width = loadInt32(data + sizeof(int64_t));
+            const char* words = data + sizeof(int64_t) + sizeof(int32_t);
+            for(int32_t i = 0; i < count; ++i){
+                storeInt(value(i), size, minimum + (int64_t)unpack(words, from + i, width));
+            }
+            break;
+        }
+    }
+}
+
+void CompressedPage::expand(const char* page, char* rows) const{
+    for(size_t field = 0; field < fieldSizes.size(); ++field) decodeField(page, field, 0, numSlots, rows);
+}
+
+void CompressedPage::read(const char* page, int32_t slot, char* row) const{
+    for(size_t field = 0; field < fieldSizes.size(); ++field) decodeField(page, field, slot, 1, row);
+}
+
+void CompressedPage::match(const char* page, int32_t field, int32_t from, int32_t count,
+                           const ColumnPredicate& predicate, uint8_t* matches) const{
+    const uint32_t size = fieldSizes[field];
+    const char* data = fieldData(page, field);
+    std::vector<char> value(size, 0);
+    if(data == nullptr){
+        memset(matches, predicate.test(value.data()), count);
+        return;
+    }
+
+    switch(encoding(page, field)){
+        case ColumnEncoding::plain:
+            for(int32_t i = 0; i < count; ++i) matches[i] = predicate.test(data + (int64_t)(from + i) * size);
+            break;
+
+        case ColumnEncoding::dictionary: {
+            int32_t entries = loadInt32(data);
+            const char* bytes = data + sizeof(int32_t) * (1 + entries);
+            const char* codes = bytes + loadInt32(data + sizeof(int32_t) * entries);
+            uint8_t entryMatches[MAX_DICTIONARY_SIZE];
+            int32_t start = 0;
+            for(int32_t code = 0; code < entries; ++code){
+                int32_t end = loadInt32(data + sizeof(int32_t) * (code + 1));
+                memset(value.data(), 0, size);
+                memcpy(value.data(), bytes + start, end - start);
+                entryMatches[code] = predicate.test(value.data());
+                start = end;
+            }
+            for(int32_t i = 0; i < count; ++i) matches[i] = entryMatches[(uint8_t)codes[from + i]];
+            break;
+        }
+
+        case ColumnEncoding::runLength: {
+            const int32_t runSize = sizeof(int32_t) + size;
+            const char* runs = data + sizeof(int32_t);
+            int32_t run = findRun(runs, loadInt32(data), runSize, from);
+            for(int32_t i = 0; i < count; ++run){
+                int32_t end = std::min(loadInt32(runs + run * runSize) - from, count);
+                memset(matches + i, predicate.test(runs + run * runSize + sizeof(int32_t)), end - i);
+                i = end;
+            }
+            break;
+        }
+
+        case ColumnEncoding::frameOfReference: {
+            int64_t minimum;
+            memcpy(&minimum, data, sizeof(int64_t));
+            int32_t width = loadInt32(data + sizeof(int64_t));
+            const char* words = data + sizeof(int64_t) + sizeof(int32_t);
+            if(!predicate.isRange){
+                for(int32_t i = 0; i < count; ++i){
+                    storeInt(value.data(), size, minimum + (int64_t)unpack(words, from + i, width));
+                    matches[i] = predicate.test(value.data());
+                }
+                break;
+            }
+
+            // Bounds are moved into offset space once, offsets are never decoded
+            int64_t maximum = minimum + (int64_t)((1ULL << width) - 1);
+            if(predicate.low > maximum || predicate.high < minimum || predicate.low > predicate.high){
+                memset(matches, predicate.negate, count);
+                break;
+            }
+            int64_t low = std::max(predicate.low, minimum) - minimum;
+            int64_t high = std::min(predicate.high, maximum) - minimum;
+            auto span = (uint64_t)(high - low);
+            for(int32_t i = 0; i < count; ++i){
+                matches[i] = ((unpack(words, from + i, width) - (uint64_t)low) <= span) != predicate.negate;
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstring>
+#include "HeaderFiles/Table.h"
+#include "HeaderFiles/CoveringIndex.h"
+
+// =============================================
+//                  COVERING INDEX
+// =============================================
+
+namespace{
+    const int32_t ROOT_OFFSET = 0;
+    const int32_t NUM_PAGES_OFFSET = sizeof(row_t);
+    const int32_t COLUMNS_OFFSET = 2 * sizeof(row_t);
+
+    void writeColumns(const std::vector<int32_t>& columns, char*& dest){
+        int32_t count = columns.size();
+        memcpy(dest, &count, sizeof(int32_t));
+        dest += sizeof(int32_t);
+        memcpy(dest, columns.data(), count * sizeof(int32_t));
+        dest += count * sizeof(int32_t);
+    }
+
+    std::vector<int32_t> readColumns(const char*& src){
+        int32_t count;
+        memcpy(&count, src, sizeof(int32_t));
+        src += sizeof(int32_t);
+        std::vector<int32_t> columns(count);
+        memcpy(columns.data(), src, count * sizeof(int32_t));
+        src += count * sizeof(int32_t);
+        return columns;
+    }
+}
+
+CoveringIndex::CoveringIndex(const std::string& fileName, std::vector<int32_t> keyColumns_, std::vector<int32_t> includedColumns_,
+                             const std::vector<DataType>& columnTypes, const std::vector<uint32_t>& columnSizes_):
+                             pager(fileName.c_str()), columnSizes(columnSizes_){
+    row_t root = 0, numPages = 0;
+    if(pager.getFileLength() == 0){
+        this->keyColumns = std::move(keyColumns_);
+        for(int32_t column: includedColumns_){
+            // A key column is stored once
+            if(std::find(keyColumns.begin(), keyColumns.end(), column) != keyColumns.end()) continue;
+            if(std::find(includedColumns.begin(), includedColumns.end(), column) != includedColumns.end()) continue;
+            includedColumns.push_back(column);
+        }
+    }
+    else{
+        const char* buffer = pager.header->buffer.get();
+        memcpy(&root, buffer + ROOT_OFFSET, sizeof(row_t));
+        memcpy(&numPages, buffer + NUM_PAGES_OFFSET, sizeof(row_t));
+        const char* columns = buffer + COLUMNS_OFFSET;
+        this->keyColumns = readColumns(columns);
+        this->includedColumns = readColumns(columns);
+    }
+    for(int32_t column: keyColumns){
+        if(column < 0 || column >= (int32_t)columnSizes.size()) throw std::runtime_error("Invalid covering index column");
+    }
+    for(int32_t column: includedColumns){
+        if(column < 0 || column >= (int32_t)columnSizes.size()) throw std::runtime_error("Invalid covering index column");
+    }
+
+    this->rowSize = 0;
+    for(uint32_t size: columnSizes){
+        columnOffsets.push_back(rowSize);
+        rowSize += size;
+    }
+    rowSize += sizeof(pkey_t);
+
+    coveredColumns = keyColumns;
+    coveredColumns.insert(coveredColumns.end(), includedColumns.begin(), includedColumns.end());
+    RecordFormat format;
+    for(int32_t column: coveredColumns){
+        recordOffsets.push_back(format.recordSize);
+        if(recordOffsets.size() <= keyColumns.size()){
+            format.keyColumns.push_back({columnTypes[column], format.recordSize, (int32_t)columnSizes[column]});
+        }
+        format.recordSize += columnSizes[column];
+    }
+    format.pkeyOffset = format.recordSize;
+    format.rowOffset = format.pkeyOffset + sizeof(pkey_t);
+    format.recordSize = format.rowOffset + sizeof(row_t);
+    this->recordSize = format.recordSize;
+    this->keySize = keyColumns.empty() ? 0 : columnSizes[keyColumns[0]];
+    this->tree = std::make_unique<ClusteredTree>(&pager, nullptr, std::move(format), root, numPages);
+    storeHeader();
+}
+
+void CoveringIndex::storeHeader(){
+    char* buffer = pager.header->buffer.get();
+    row_t root = tree->getRoot(), numPages = tree->getNumPages();
+    memcpy(buffer + ROOT_OFFSET, &root, sizeof(row_t));
+    memcpy(buffer + NUM_PAGES_OFFSET, &numPages, sizeof(row_t));
+    char* columns = buffer + COLUMNS_OFFSET;
+    writeColumns(keyColumns, columns);
+    writeColumns(includedColumns, columns);
+    pager.header->hasUncommitedChanges = true;
+}
+
+void CoveringIndex::makeRecord(const char* row, row_t location, char* record) const{
+    for(size_t i = 0; i < coveredColumns.size(); ++i){
+        int32_t column = coveredColumns[i];
+        memcpy(record + recordOffsets[i], row + columnOffsets[column], columnSizes[column]);
+    }
+    int32_t pkeyOffset = recordSize - sizeof(row_t) - sizeof(pkey_t);
+    memcpy(record + pkeyOffset, row + rowSize - sizeof(pkey_t), sizeof(pkey_t));
+    memcpy(record + pkeyOffset + sizeof(pkey_t), &location, sizeof(row_t));
+}
+
+const std::vector<int32_t>& CoveringIndex::getKeyColumns() const{
+    return this->keyColumns;
+}
+
+const std::vector<int32_t>& CoveringIndex::getIncludedColumns() const{
+    return this->includedColumns;
+}
+
+// ----------------------- MAINTENANCE ----------------------
+
+bool CoveringIndex::insert(const char* row, row_t location){
+    std::vector<char> record(recordSize);
+    makeRecord(row, location, record.data());
+    bool res = tree->insert(record.data()) != -1;
+    storeHeader();
+    return res;
+}
+
+bool CoveringIndex::remove(const char* row){
+    std::vector<char> record(recordSize);
+    makeRecord(row, -1, record.data());
+    return tree->remove(record.data());
+}
+
+bool CoveringIndex::update(const char* oldRow, row_t oldLocation, const char* newRow, row_t newLocation){
+    std::vector<char> oldRecord(recordSize), newRecord(recordSize);
+    makeRecord(oldRow, oldLocation, oldRecord.data());
+    makeRecord(newRow, newLocation, newRecord.data());
+    if(memcmp(oldRecord.data(), newRecord.data(), recordSize) == 0) return true;
+    if(!tree->remove(oldRecord.data())) return false;
+    return insert(newRow, newLocation);
+}
+
+bool CoveringIndex::flushAll(){
+    return pager.flushAll();
+}
+
+bool CoveringIndex::close(){
+    return pager.close();
+}
+
+// ----------------------- SCANS ----------------------
+
+bool CoveringIndex::traverse(const std::function<bool(row_t row)>& callback){
+    return tree->traverse(callback);
+}
+
+bool CoveringIndex::rangeScan(const KeyRange& range, const std::function<bool(row_t row)>& callback){
+    return tree->rangeScan(range, callback);
+}
+
+bool CoveringIndex::rangeScanKeys(const KeyRange& range, const std::function<bool(const std::string& key)>& callback){
+    return tree->rangeScanKeys(range, callback);
+}
+
+bool CoveringIndex::rangeScanReverse(const KeyRange& range, const std::function<bool(row_t row)>& callback){
+    return tree->rangeScanReverse(range, callback);
+}
+
+IndexStatistics CoveringIndex::statistics(){
+    return tree->statistics();
+}
+
+bool CoveringIndex::firstKey(std::string& key){
+    return tree->firstKey(key);
+}
+
+bool CoveringIndex::lastKey(std::string& key){
+    return tree->lastKey(key);
+}
+
+void CoveringIndex::setPageCompression(bool enabled){
+    pager.setPageCompression(enabled);
+}
+
+bool CoveringIndex::naturalJoinOneIndex(const std::string& keyOfOther, row_t rowOfOther, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback){
+    return tree->naturalJoinOneIndex(keyOfOther, rowOfOther, callback);
+}
+
+bool CoveringIndex::covers(int32_t column){
+    return std::find(coveredColumns.begin(), coveredColumns.end(), column) != coveredColumns.end();
+}
+
+bool CoveringIndex::rangeScanCovered(const KeyRange& range, const std::function<bool(char* row)>& callback){
+    std::vector<char> row(rowSize, 0);
+    int32_t pkeyOffset = recordSize - sizeof(row_t) - sizeof(pkey_t);
+    return tree->scan(range, false, [&](row_t location, const char* record)->bool{
+        for(size_t i = 0; i < coveredColumns.size(); ++i){
+            int32_t column = coveredColumns[i];
+            memcpy(row.data() + columnOffsets[column], record + recordOffsets[i], columnSizes[column]);
+        }
+        memcpy(row.data() + rowSize - sizeof(pkey_t), record + pkeyOffset, sizeof(pkey_t));
+        return callback(row.data());
+    });
+}
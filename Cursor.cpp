@@ -8,7 +8,7 @@ Cursor::Cursor(Table* table){
 }
 
 Cursor Cursor::operator++(){
-    if(this->row < this->table->numRows - 1){
+    if(this->row < this->table->numSlots() - 1){
         ++this->row;
     }
     else{
@@ -19,23 +19,23 @@ Cursor Cursor::operator++(){
 
 char* Cursor::value(){
     // TODO: Correct this after adding table header
-    uint32_t pageNum = (row / table->rowsPerPage) + 1;
+    row_t pageNum = (row / table->rowsPerPage) + 1;
     this->page = table->pager->read(pageNum);
     if(page == nullptr){return nullptr;}
     // Read Successful
-    uint32_t rowOffset = row % table->rowsPerPage;
-    uint32_t byteOffset = rowOffset * table->rowSize;
-    return page->buffer.get() + byteOffset;
+    int32_t rowOffset = row % table->rowsPerPage;
+    int64_t byteOffset = (int64_t)rowOffset * table->rowSize;
+    return table->pageRows(page) + byteOffset;
 }
 
-void Cursor::addedChangesToCommit(){
-    if(page != nullptr) page->hasUncommitedChanges = true;
+bool Cursor::addedChangesToCommit(){
+    if(page == nullptr) return false;
+    return table->storeRow(page, row);
 }
 
-void Cursor::commitChanges(){
-    if(page != nullptr){
-        uint32_t pageNum = row / table->rowsPerPage;
-        page->hasUncommitedChanges = true;
-        this->table->pager->flush(pageNum);
-    }
+bool Cursor::commitChanges(){
+    if(page == nullptr) return false;
+    row_t pageNum = row / table->rowsPerPage + 1;
+    if(!table->storeRow(page, row)) return false;
+    return this->table->pager->flush(pageNum);
 }
\ No newline at end of file
@@ -8,9 +8,19 @@ enum class ExecuteResult{
     stringTooLarge,
     invalidColumnName,
     tableNotIndexed,
+    invalidAggregate,
     unexpectedError
 };
 
+#include "BatchExecutor.cpp"
+#include "TableScan.cpp"
+#include "Optimizer.cpp"
+#include "Join.cpp"
+#include "TableSort.cpp"
+#include "Aggregate.cpp"
+#include "OrderBy.cpp"
+
+
 struct ErrorHandler{
     static void handleTableManagerError(const TableManagerResult& res){
         switch(res){
@@ -95,6 +105,9 @@ public:
             case StatementType::drop:
                 res = executeDrop(parser.statement);
                 break;
+            case StatementType::join:
+                res = executeJoin(parser.statement);
+                break;
         }
         return res;
     }
@@ -109,7 +122,8 @@ private:
         auto res = sharedManager->create(createStatement->tableName,
                                          std::move(createStatement->colNames),
                                          std::move(createStatement->colTypes),
-                                         std::move(createStatement->colSize));
+                                         std::move(createStatement->colSize),
+                                         createStatement->options);
 
         ErrorHandler::handleTableManagerError(res);
         if(res == TableManagerResult::tableCreatedSuccessfully){
@@ -126,15 +140,25 @@ private:
         }
 
         auto insertStatement = dynamic_cast<IndexStatement*>(statement.get());
+        if(insertStatement->colNames.size() > 1 || !insertStatement->includeNames.empty()){
+            return executeCoveringIndex(table, insertStatement);
+        }
         for(auto& colName: insertStatement->colNames){
             auto itr = table->columnIndex.find(colName);
             if(itr == table->columnIndex.end()){
                 return ExecuteResult::invalidColumnName;
             }
             int32_t index = itr->second;
+            if(table->getLayout() == TableLayout::clustered){
+                // Rows move between leaves on every split, only clustered tree itself can find them
+                if(index == table->getClusterColumn()) continue;
+                printf("Secondary indexes aren't supported on clustered tables.\n");
+                ErrorHandler::indexCreationError(colName);
+                return ExecuteResult::faliure;
+            }
             if(!table->indexed[index]){
                 table->indexed[index] = true;
-                if(!sharedManager->createIndex(table, index)){
+                if(!sharedManager->createIndex(table, index) || !buildIndex(table, index)){
                     ErrorHandler::indexCreationError(colName);
                     return ExecuteResult::faliure;
                 }
@@ -146,6 +170,68 @@ private:
         return ExecuteResult::success;
     }
 
+    /// Composite index on key columns, or covering index storing included columns too
+    ExecuteResult executeCoveringIndex(std::shared_ptr<Table>& table, IndexStatement* indexStatement){
+        const std::string& colName = indexStatement->colNames[0];
+        std::vector<int32_t> keyColumns;
+        for(auto& keyName: indexStatement->colNames){
+            auto keyItr = table->columnIndex.find(keyName);
+            if(keyItr == table->columnIndex.end()) return ExecuteResult::invalidColumnName;
+            if(std::find(keyColumns.begin(), keyColumns.end(), keyItr->second) != keyColumns.end()){
+                printf("Column %s is repeated in key of index.\n", keyName.c_str());
+                return ExecuteResult::faliure;
+            }
+            keyColumns.push_back(keyItr->second);
+        }
+        int32_t index = keyColumns[0];
+        std::vector<int32_t> included;
+        for(auto& includeName: indexStatement->includeNames){
+            auto includeItr = table->columnIndex.find(includeName);
+            if(includeItr == table->columnIndex.end()) return ExecuteResult::invalidColumnName;
+            included.push_back(includeItr->second);
+        }
+        if(table->getLayout() == TableLayout::clustered){
+            printf("Secondary indexes aren't supported on clustered tables.\n");
+            ErrorHandler::indexCreationError(colName);
+            return ExecuteResult::faliure;
+        }
+        if(table->coveringIndex(index) != nullptr){
+            // Index file is named after first key column
+            printf("Column already leads a composite or covering index.\n");
+            ErrorHandler::indexCreationError(colName);
+            return ExecuteResult::faliure;
+        }
+        if(!sharedManager->createCoveringIndex(table, keyColumns, included)){
+            ErrorHandler::indexCreationError(colName);
+            return ExecuteResult::faliure;
+        }
+        TableScan scan(table.get(), {});
+        while(char* buffer = scan.next()){
+            if(!table->coveringIndex(index)->insert(buffer, scan.row())){
+                ErrorHandler::indexCreationError(colName);
+                return ExecuteResult::faliure;
+            }
+        }
+        ErrorHandler::indexCreationSuccessful(colName);
+        return ExecuteResult::success;
+    }
+
+    /// Inserts rows already present in table into newly created index
+    bool buildIndex(std::shared_ptr<Table>& table, int32_t index){
+        std::vector<std::string> data(table->columnNames.size());
+        pkey_t pkey;
+        TableScan scan(table.get(), {});
+        while(char* buffer = scan.next()){
+            if(!deserializeRow(buffer, table, data, pkey)) return false;
+            bool res = true;
+            switch(table->columnTypes[index]){
+                BTREE_HANDLER(res, table->trees[index].get(), insert(data[index], pkey, scan.row()))
+            }
+            if(!res) return false;
+        }
+        return true;
+    }
+
     ExecuteResult executeInsert(std::unique_ptr<QueryStatement>& statement){
         std::shared_ptr<Table> table;
         auto res = sharedManager->open(statement->tableName, table);
@@ -153,7 +239,6 @@ private:
         if(res != TableManagerResult::openedSuccessfully) {
             return ExecuteResult::faliure;
         }
-        if(!table->tableIsIndexed) return ExecuteResult::tableNotIndexed;
         auto insertStatement = dynamic_cast<InsertStatement*>(statement.get());
         int32_t columnCount = table->columnNames.size();
         int32_t actualSize = insertStatement->data.size();
@@ -162,6 +247,19 @@ private:
             return ExecuteResult::faliure;
         }
 
+        // Clustered table places row in leaf of its key, so it is serialized before its slot is known
+        if(table->getLayout() == TableLayout::clustered){
+            auto row = std::make_unique<char[]>(table->getRowSize());
+            auto serializeRes = serializeRow(row.get(), table.get(), insertStatement->data, table->nextPKey);
+            if(serializeRes != ExecuteResult::success) return serializeRes;
+            if(table->insertClustered(row.get()) == -1){
+                printf("Duplicate key in clustered column.\n");
+                return ExecuteResult::faliure;
+            }
+            table->increaseRowCount();
+            return ExecuteResult::success;
+        }
+
         // Serialise Data;
         Cursor cursor(table.get());
         cursor.row = table->nextFreeRowLocation();
@@ -169,8 +267,8 @@ private:
         if(buffer == nullptr) return ExecuteResult::unexpectedError;
         auto serializeRes = serializeRow(buffer, table.get(), insertStatement->data, table->nextPKey);
         if(serializeRes != ExecuteResult::success) return serializeRes;
+        if(!cursor.addedChangesToCommit()) return ExecuteResult::unexpectedError;
         table->increaseRowCount();
-        cursor.addedChangesToCommit();
 
         if(!table->insertBTree(insertStatement->data, cursor.row)){
             return ExecuteResult::faliure;
@@ -187,24 +285,168 @@ private:
             return ExecuteResult::faliure;
         }
         auto selectStatement = dynamic_cast<SelectStatement*>(statement.get());
+        if(!selectStatement->aggregates.empty()) return executeAggregate(table, selectStatement);
 
         std::vector<int32_t> indices;
         if(!selectStatement->selectAllCols){
             for(auto& str: selectStatement->colNames){
-                int32_t index = table->columnIndex[str];
-                indices.emplace_back(index);
+                auto itr = table->columnIndex.find(str);
+                if(itr == table->columnIndex.end()) return ExecuteResult::invalidColumnName;
+                indices.emplace_back(itr->second);
+            }
+            std::sort(indices.begin(), indices.end());
+        }
+
+        std::vector<PredicateKernel> kernels;
+        if(!selectStatement->selectAllRows){
+            auto& condition = selectStatement->condition;
+            if(table->columnIndex.find(condition.col) == table->columnIndex.end() ||
+               table->columnIndex.find(condition.col2) == table->columnIndex.end()){
+                return ExecuteResult::invalidColumnName;
+            }
+            if(!PredicateKernel::compile(table.get(), condition, kernels)){
+                return ExecuteResult::typeMismatch;
             }
         }
 
+        int32_t orderIndex = -1;
+        if(!selectStatement->orderBy.empty()){
+            auto itr = table->columnIndex.find(selectStatement->orderBy);
+            if(itr == table->columnIndex.end()) return ExecuteResult::invalidColumnName;
+            orderIndex = itr->second;
+        }
+
         int32_t size = selectStatement->selectAllCols ? table->columnNames.size(): indices.size();
+        std::vector<std::string> data(size);
         row_t count = 0;
-        auto callback = [&](row_t row)->bool{
+        int64_t limit = selectStatement->limit;
+
+        // Returns false once limit is reached so that readers stop early
+        auto printRow = [&]()->bool{
+            for(auto& str: data){
+                std::cout << str << " | ";
+            }
+            std::cout << std::endl;
+            ++count;
+            return limit < 0 || count < limit;
+        };
+        auto limitReached = [&](){ return limit >= 0 && count >= limit; };
+
+        bool deserializeRes = true;
+        auto emitRow = [&](char* buffer)->bool{
+            deserializeRes = deserializeRow(buffer, table, indices, data, selectStatement->selectAllCols);
+            if(!deserializeRes) return false;
+            return printRow();
+        };
+
+        // Rows fetched through an index are checked against every predicate
+        // as a range can't express all conditions
+        auto fetchCallback = [&](row_t row)->bool{
             Cursor cursor(table.get());
             cursor.row = row;
             char* buffer = cursor.value();
-            std::vector<std::string> data(size);
-            bool deserializeRes = deserializeRow(buffer, table, indices, data, selectStatement->selectAllCols);
-            if(!deserializeRes) return false;
+            if(buffer == nullptr) return false;
+            for(auto& kernel: kernels){
+                if(!kernel.matches(buffer)) return true;
+            }
+            return emitRow(buffer);
+        };
+
+        // Covered columns of a leaf record, no table page is read
+        auto coveredCallback = [&](char* row)->bool{
+            for(auto& kernel: kernels){
+                if(!kernel.matches(row)) return true;
+            }
+            return emitRow(row);
+        };
+
+        auto keyCallback = [&](const std::string& key)->bool{
+            for(auto& str: data) str = key;
+            return printRow();
+        };
+
+        if(limit == 0){
+            printf("Found %" PRId64 " row(s).\n", count);
+            return ExecuteResult::success;
+        }
+
+        if(orderIndex != -1){
+            // External sort of a large table throws on I/O errors of its runs
+            bool res;
+            try{
+                res = OrderBy::run(table.get(), selectStatement, orderIndex, kernels, emitRow);
+            }
+            catch(const std::exception& e){
+                printf("Sort failed: %s\n", e.what());
+                return ExecuteResult::faliure;
+            }
+            if(!res || !deserializeRes) return ExecuteResult::unexpectedError;
+            printf("Found %" PRId64 " row(s).\n", count);
+            return ExecuteResult::success;
+        }
+
+        AccessPlan plan = Optimizer::choosePath(table.get(), selectStatement, indices);
+        switch(plan.path){
+            case AccessPath::indexLookup:
+            case AccessPath::indexRangeScan:
+                if(!plan.tree->rangeScan(plan.range, fetchCallback) && !limitReached()){
+                    return ExecuteResult::unexpectedError;
+                }
+                break;
+
+            case AccessPath::indexOnlyScan:
+                if(!plan.tree->rangeScanKeys(plan.range, keyCallback) && !limitReached()){
+                    return ExecuteResult::unexpectedError;
+                }
+                break;
+
+            case AccessPath::coveringIndexScan:
+                if(!plan.tree->rangeScanCovered(plan.range, coveredCallback) && !limitReached()){
+                    return ExecuteResult::unexpectedError;
+                }
+                break;
+
+            case AccessPath::tableScan: {
+                BatchScanner scanner(table.get());
+                RowBatch batch(table->getRowSize());
+                while(!limitReached() && scanner.next(batch, kernels)){
+                    // Materialize only qualifying rows
+                    for(int32_t i = 0; i < batch.selected; ++i){
+                        if(!emitRow(batch.row(batch.selection[i]))) break;
+                    }
+                    if(!deserializeRes) return ExecuteResult::unexpectedError;
+                }
+                break;
+            }
+        }
+        if(!deserializeRes) return ExecuteResult::unexpectedError;
+        printf("Found %" PRId64 " row(s).\n", count);
+        return ExecuteResult::success;
+    }
+
+    ExecuteResult executeAggregate(std::shared_ptr<Table>& table, SelectStatement* selectStatement){
+        Aggregator aggregator;
+        auto compileRes = aggregator.compile(table.get(), selectStatement);
+        if(compileRes != ExecuteResult::success) return compileRes;
+
+        std::vector<PredicateKernel> kernels;
+        if(!selectStatement->selectAllRows){
+            auto& condition = selectStatement->condition;
+            if(table->columnIndex.find(condition.col) == table->columnIndex.end() ||
+               table->columnIndex.find(condition.col2) == table->columnIndex.end()){
+                return ExecuteResult::invalidColumnName;
+            }
+            if(!PredicateKernel::compile(table.get(), condition, kernels)){
+                return ExecuteResult::typeMismatch;
+            }
+        }
+
+        std::vector<std::string> data;
+        row_t count = 0;
+        // Groups after limit are still aggregated as they come from same pass, just not printed
+        auto printGroup = [&](const std::string& key, const std::vector<AggregateState>& states)->bool{
+            if(selectStatement->limit >= 0 && count >= selectStatement->limit) return true;
+            aggregator.finalize(key, states, data);
             for(auto& str: data){
                 std::cout << str << " | ";
             }
@@ -213,41 +455,207 @@ private:
             return true;
         };
 
-        if(selectStatement->selectAllRows){
-            bool traverseRes = table->trees[table->anyIndex]->traverse(callback);
-            if(!traverseRes) return ExecuteResult::unexpectedError;
-            printf("Found %d row(s).\n", count);
-            return ExecuteResult::success;
+        AggregatePlan plan = AggregatePlanner::choose(table.get(), aggregator, selectStatement);
+        switch(plan.strategy){
+            case AggregateStrategy::indexBounds: {
+                data.resize(aggregator.columns.size());
+                for(size_t i = 0; i < aggregator.columns.size(); ++i){
+                    auto& column = aggregator.columns[i];
+                    if(column.type == AggregateType::count){
+                        data[i] = std::to_string(table->getNumRows());
+                        continue;
+                    }
+                    BPlusTreeBase* tree = table->index(column.index);
+                    bool found = (column.type == AggregateType::min) ? tree->firstKey(data[i]) : tree->lastKey(data[i]);
+                    if(!found) data[i] = "NULL";
+                }
+                if(selectStatement->limit == 0) break;
+                for(auto& str: data){
+                    std::cout << str << " | ";
+                }
+                std::cout << std::endl;
+                ++count;
+                break;
+            }
+
+            case AggregateStrategy::sortAggregate:
+                if(!SortAggregate::run(table.get(), aggregator, plan.range, plan.indexOnly, kernels, printGroup)){
+                    return ExecuteResult::unexpectedError;
+                }
+                break;
+
+            case AggregateStrategy::hashAggregate: {
+                TableScan scan(table.get(), std::move(kernels));
+                HashAggregate hashAggregate(aggregator);
+                // Groups which don't fit in memory are spilled to disk, its I/O errors are thrown
+                try{
+                    if(!hashAggregate.run(scan, table->getRowSize(), printGroup)) return ExecuteResult::unexpectedError;
+                }
+                catch(const std::exception& e){
+                    printf("Aggregation failed: %s\n", e.what());
+                    return ExecuteResult::faliure;
+                }
+                break;
+            }
         }
 
-        auto condition = std::move(selectStatement->condition);
-        int32_t index = table->columnIndex[condition.col];
-
-//        if(condition.isCompound){
-//
-//        }
-//        else{
-//            switch(condition.compType1){
-//                case ComparisonType::equal:
-////                    table->bPlusTrees[index]
-//                    break;
-//                case ComparisonType::notEqual:
-//                    break;
-//                case ComparisonType::lessThan:
-//                    break;
-//                case ComparisonType::greaterThan:
-//                    break;
-//                case ComparisonType::lessThanOrEqual:
-//                    break;
-//                case ComparisonType::greaterThanOrEqual:
-//                    break;
-//                default: break;
-//            }
-//        }
+        // Without group by there is always one row even if no row matched
+        if(count == 0 && aggregator.groupIndex == -1 && selectStatement->limit != 0){
+            printGroup("", std::vector<AggregateState>(aggregator.columns.size()));
+        }
+        printf("Found %" PRId64 " row(s).\n", count);
+        return ExecuteResult::success;
+    }
+
+    ExecuteResult executeJoin(std::unique_ptr<QueryStatement>& statement){
+        auto joinStatement = dynamic_cast<JoinStatement*>(statement.get());
+        const std::string names[2] = {joinStatement->tableName, joinStatement->rightTableName};
+        std::shared_ptr<Table> tables[2];
+        for(int side = 0; side < 2; ++side){
+            auto res = sharedManager->open(names[side], tables[side]);
+            if(res != TableManagerResult::openedSuccessfully){
+                ErrorHandler::handleTableManagerError(res);
+                return ExecuteResult::faliure;
+            }
+        }
+
+        // Join columns. Unqualified names belong to table on their side of `==`
+        int32_t joinIndex[2];
+        int leftSide = 0, rightSide = 1;
+        if(!resolveJoinColumn(joinStatement->leftCol, tables, names, leftSide, joinIndex[0]) ||
+           !resolveJoinColumn(joinStatement->rightCol, tables, names, rightSide, joinIndex[1]) ||
+           leftSide == rightSide){
+            return ExecuteResult::invalidColumnName;
+        }
+        if(leftSide == 1) std::swap(joinIndex[0], joinIndex[1]);
+        if(tables[0]->columnTypes[joinIndex[0]] != tables[1]->columnTypes[joinIndex[1]]){
+            return ExecuteResult::typeMismatch;
+        }
+
+        // Selected columns. Unqualified names are looked up in left table first
+        std::vector<int32_t> indices[2];
+        if(!joinStatement->selectAllCols){
+            for(auto& colName: joinStatement->colNames){
+                int side = -1;
+                int32_t index;
+                if(!resolveJoinColumn(colName, tables, names, side, index)) return ExecuteResult::invalidColumnName;
+                indices[side].emplace_back(index);
+            }
+            std::sort(indices[0].begin(), indices[0].end());
+            std::sort(indices[1].begin(), indices[1].end());
+        }
+
+        std::vector<std::string> data[2];
+        std::unique_ptr<char[]> rowBuffer[2];
+        for(int side = 0; side < 2; ++side){
+            data[side].resize(joinStatement->selectAllCols ? tables[side]->columnNames.size() : indices[side].size());
+            rowBuffer[side] = std::make_unique<char[]>(tables[side]->getRowSize());
+        }
+
+        row_t count = 0;
+        auto emit = [&](char* leftRow, char* rightRow)->bool{
+            char* rows[2] = {leftRow, rightRow};
+            for(int side = 0; side < 2; ++side){
+                if(!deserializeRow(rows[side], tables[side], indices[side], data[side], joinStatement->selectAllCols)) return false;
+                for(auto& str: data[side]){
+                    std::cout << str << " | ";
+                }
+            }
+            std::cout << std::endl;
+            ++count;
+            return true;
+        };
 
+        // Rows are copied out of page as other side may evict it when both sides are same table
+        auto fetchRow = [&](int side, row_t row)->char*{
+            Cursor cursor(tables[side].get());
+            cursor.row = row;
+            char* buffer = cursor.value();
+            if(buffer == nullptr) return nullptr;
+            memcpy(rowBuffer[side].get(), buffer, tables[side]->getRowSize());
+            return rowBuffer[side].get();
+        };
+
+        JoinPlan plan = JoinPlanner::choose(tables[0].get(), joinIndex[0], tables[1].get(), joinIndex[1]);
+        bool joinRes = true;
+        switch(plan.strategy){
+            case JoinStrategy::sortMerge:
+                joinRes = tables[0]->index(joinIndex[0])->naturalJoinBothIndex(*tables[1]->index(joinIndex[1]),
+                        [&](row_t leftRow, row_t rightRow)->bool{
+                    char* leftBuffer = fetchRow(0, leftRow);
+                    char* rightBuffer = fetchRow(1, rightRow);
+                    if(leftBuffer == nullptr || rightBuffer == nullptr) return false;
+                    return emit(leftBuffer, rightBuffer);
+                });
+                break;
+
+            case JoinStrategy::indexNestedLoop: {
+                int inner = plan.leftIsInner ? 0 : 1;
+                int outer = 1 - inner;
+                std::vector<int32_t> keyIndex = {joinIndex[outer]};
+                std::vector<std::string> key(1);
+                TableScan scan(tables[outer].get(), {});
+                while(char* buffer = scan.next()){
+                    memcpy(rowBuffer[outer].get(), buffer, tables[outer]->getRowSize());
+                    if(!deserializeRow(rowBuffer[outer].get(), tables[outer], keyIndex, key, false)) return ExecuteResult::unexpectedError;
+                    joinRes = tables[inner]->index(joinIndex[inner])->naturalJoinOneIndex(key[0], scan.row(),
+                            [&](row_t innerRow, row_t outerRow)->bool{
+                        char* innerBuffer = fetchRow(inner, innerRow);
+                        if(innerBuffer == nullptr) return false;
+                        return (inner == 0) ? emit(innerBuffer, rowBuffer[1].get()) : emit(rowBuffer[0].get(), innerBuffer);
+                    });
+                    if(!joinRes) break;
+                }
+                break;
+            }
+
+            case JoinStrategy::hash: {
+                int build = plan.leftIsInner ? 0 : 1;
+                // Grace hash join spills partitions to disk and throws on I/O errors
+                try{
+                    joinRes = HashJoin::run(tables[build].get(), joinIndex[build], tables[1 - build].get(), joinIndex[1 - build],
+                            [&](char* buildRow, char* probeRow)->bool{
+                        return (build == 0) ? emit(buildRow, probeRow) : emit(probeRow, buildRow);
+                    });
+                }
+                catch(const std::exception& e){
+                    printf("Join failed: %s\n", e.what());
+                    return ExecuteResult::faliure;
+                }
+                break;
+            }
+        }
+        if(!joinRes) return ExecuteResult::unexpectedError;
+        printf("Found %" PRId64 " row(s).\n", count);
         return ExecuteResult::success;
     }
 
+    /// Resolves <col> or <table>.<col> of a join
+    /// If side is -1 unqualified name is looked up in both tables, left first
+    /// Otherwise unqualified name is looked up in table of given side
+    static bool resolveJoinColumn(const std::string& name, std::shared_ptr<Table> (&tables)[2], const std::string (&names)[2], int& side, int32_t& index){
+        std::string colName = name;
+        auto dot = name.find('.');
+        if(dot != std::string::npos){
+            std::string tableName = name.substr(0, dot);
+            colName = name.substr(dot + 1);
+            if(tableName == names[0]) side = 0;
+            else if(tableName == names[1]) side = 1;
+            else return false;
+        }
+
+        for(int s = 0; s < 2; ++s){
+            if(side != -1 && side != s) continue;
+            auto itr = tables[s]->columnIndex.find(colName);
+            if(itr != tables[s]->columnIndex.end()){
+                side = s;
+                index = itr->second;
+                return true;
+            }
+        }
+        return false;
+    }
+
     ExecuteResult executeUpdate(std::unique_ptr<QueryStatement>& statement){
         std::shared_ptr<Table> table;
         auto res = sharedManager->open(statement->tableName, table);
@@ -256,49 +664,84 @@ private:
         }
 
         auto updateStatement = dynamic_cast<UpdateStatement*>(statement.get());
+
+        // serializeRow expects updated columns in table order
+        std::vector<std::pair<int32_t, std::string>> updates;
+        for(int i = 0; i < updateStatement->colNames.size(); ++i){
+            auto itr = table->columnIndex.find(updateStatement->colNames[i]);
+            if(itr == table->columnIndex.end()) return ExecuteResult::invalidColumnName;
+            if(itr->second == table->getClusterColumn()){
+                // Row would have to move to leaf of its new key
+                printf("Key column of a clustered table can't be updated.\n");
+                return ExecuteResult::faliure;
+            }
+            updates.emplace_back(itr->second, updateStatement->colValues[i]);
+        }
+        std::sort(updates.begin(), updates.end());
         std::vector<int32_t> indices;
-        for(auto& str: updateStatement->colNames){
-            int32_t index = table->columnIndex[str];
-            indices.emplace_back(index);
-        }
-        // TODO: Search Btree for given condition
-        //       Read Matched Records
-        if(!updateStatement->condition.isCompound){
-            // Single Column
-            int colIndex = table->columnIndex[updateStatement->condition.col];
-            switch(updateStatement->condition.compType1){
-                case ComparisonType::equal:
-                    //table->deleteBTree() //(updateStatement->condition.data1);
-                    //auto updateStatement = dynamic_cast<UpdateStatement*>(statement.get());
-                    break;
-                case ComparisonType::notEqual:
-                    break;
-                case ComparisonType::lessThan:
-                    break;
-                case ComparisonType::greaterThan:
-                    break;
-                case ComparisonType::lessThanOrEqual:
-                    break;
-                case ComparisonType::greaterThanOrEqual:
-                    break;
-                case ComparisonType::error:
-                    break;
-            }
-        }
-
-
-        // Call this lambda on every matched row
-        auto updateCallback = [&](Cursor& cursor)->bool{
-            char* buffer = cursor.value();
-            if(buffer == nullptr) return false;
-            auto tempBuffer = std::make_unique<char[]>(cursor.table->getRowSize() + 1);
-            strncpy(tempBuffer.get(), buffer, table->getRowSize());
-            auto serializeRes = serializeRow(tempBuffer.get(), cursor.table, updateStatement->colValues, -1, false , &indices);
-            if(serializeRes != ExecuteResult::success) return false;
-            strncpy(buffer, tempBuffer.get(), table->getRowSize());
-            cursor.addedChangesToCommit();
-            return true;
-        };
+        std::vector<std::string> values;
+        for(auto& update: updates){
+            indices.emplace_back(update.first);
+            values.emplace_back(std::move(update.second));
+        }
+
+        std::vector<PredicateKernel> kernels;
+        if(!updateStatement->updateAll){
+            auto& condition = updateStatement->condition;
+            if(table->columnIndex.find(condition.col) == table->columnIndex.end() ||
+               table->columnIndex.find(condition.col2) == table->columnIndex.end()){
+                return ExecuteResult::invalidColumnName;
+            }
+            if(!PredicateKernel::compile(table.get(), condition, kernels)){
+                return ExecuteResult::typeMismatch;
+            }
+        }
+
+        const auto size = table->columnNames.size();
+        const int32_t rowSize = table->getRowSize();
+        auto tempBuffer = std::make_unique<char[]>(rowSize);
+        auto oldBuffer = std::make_unique<char[]>(rowSize);
+        std::vector<std::string> oldData(size), newData(size);
+        row_t numRowsUpdated = 0;
+        pkey_t pkey;
+
+        TableScan scan(table.get(), std::move(kernels));
+        while(char* buffer = scan.next()){
+            memcpy(tempBuffer.get(), buffer, rowSize);
+            auto serializeRes = serializeRow(tempBuffer.get(), table.get(), values, -1, false, &indices);
+            if(serializeRes != ExecuteResult::success) return serializeRes;
+
+            if(!deserializeRow(buffer, table, oldData, pkey)) return ExecuteResult::unexpectedError;
+            if(!deserializeRow(tempBuffer.get(), table, newData, pkey)) return ExecuteResult::unexpectedError;
+
+            // Row which grew too large for its slotted page moves, every index then points to new row
+            // It moves to a slot that was free when scan started so scan doesn't visit it again
+            memcpy(oldBuffer.get(), buffer, rowSize);
+            memcpy(buffer, tempBuffer.get(), rowSize);
+            row_t row = scan.row();
+            bool relocated = !scan.current().addedChangesToCommit();
+            if(relocated){
+                row = table->relocateRow(scan.row(), tempBuffer.get());
+                if(row == -1) return ExecuteResult::unexpectedError;
+            }
+
+            // Re-key indexes on updated columns
+            for(int32_t index = 0; index < (int32_t)size; ++index){
+                if(!table->indexed[index] || (oldData[index] == newData[index] && !relocated)) continue;
+                bool updateRes = true;
+                switch(table->columnTypes[index]){
+                    BTREE_HANDLER(updateRes, table->trees[index].get(), remove(oldData[index], pkey))
+                }
+                if(!updateRes) return ExecuteResult::faliure;
+                switch(table->columnTypes[index]){
+                    BTREE_HANDLER(updateRes, table->trees[index].get(), insert(newData[index], pkey, row))
+                }
+                if(!updateRes) return ExecuteResult::faliure;
+            }
+            if(!table->updateCovering(oldBuffer.get(), scan.row(), tempBuffer.get(), row)) return ExecuteResult::faliure;
+            ++numRowsUpdated;
+        }
+        printf("Updated %" PRId64 " row(s).\n", numRowsUpdated);
         return ExecuteResult::success;
     }
 
@@ -310,9 +753,6 @@ private:
         }
 
         auto deleteStatement = dynamic_cast<DeleteStatement*>(statement.get());
-        // TODO: Search Btree for given condition
-        //       Read Matched Records
-        //       Write Updated Value
         auto callback = [&](std::vector<std::string>& data)->bool{
             for(auto& str: data){
                 std::cout << str << " | ";
@@ -321,44 +761,43 @@ private:
             return true;
         };
 
-        auto condition = deleteStatement->condition;
-        if(!condition.isCompound){
-            // Single Column
+        std::pair<bool, row_t> deleteRes;
+        auto& condition = deleteStatement->condition;
+        if(deleteStatement->deleteAll){
+            deleteRes = removeByScan(table, {}, callback);
+        }
+        else{
             auto itr = table->columnIndex.find(condition.col);
             if(itr == table->columnIndex.end()){
                 printf("Wrong Column Name.\n");
                 return ExecuteResult::faliure;
             }
             int colIndex = itr->second;
-            if(!table->indexed[colIndex]){
-                printf("Index not found on given column.\n");
-                return ExecuteResult::faliure;
+            if(table->indexed[colIndex] && !condition.isCompound && condition.compType1 == ComparisonType::equal){
+                deleteRes = remove(colIndex, condition.data1, table, callback);
             }
-            std::pair<bool, row_t> deleteRes;
-            switch(condition.compType1){
-                case ComparisonType::equal:
-                    deleteRes = remove(colIndex, condition.data1, table, callback);
-                    break;
-                case ComparisonType::notEqual:
-                    break;
-                case ComparisonType::lessThan:
-                    break;
-                case ComparisonType::greaterThan:
-                    break;
-                case ComparisonType::lessThanOrEqual:
-                    break;
-                case ComparisonType::greaterThanOrEqual:
-                    break;
-                case ComparisonType::error:
-                    break;
-            }
-            printf("Deleted %d row(s).\n", deleteRes.second);
-            if(!deleteRes.first) {
-                printf("Some Error Occurred while deleting Rows.\n");
-                return ExecuteResult::faliure;
+            else{
+                std::vector<PredicateKernel> kernels;
+                if(!PredicateKernel::compile(table.get(), condition, kernels)){
+                    return ExecuteResult::typeMismatch;
+                }
+                KeyRange range;
+                bool exact;
+                if(colIndex == table->getClusterColumn() && Optimizer::buildRange(condition, range, exact)){
+                    deleteRes = removeByRange(table, range, std::move(kernels), callback);
+                }
+                else{
+                    // No index matches condition. Fall back to table scan
+                    deleteRes = removeByScan(table, std::move(kernels), callback);
+                }
             }
         }
 
+        printf("Deleted %" PRId64 " row(s).\n", deleteRes.second);
+        if(!deleteRes.first) {
+            printf("Some Error Occurred while deleting Rows.\n");
+            return ExecuteResult::faliure;
+        }
         return ExecuteResult::success;
     }
 
@@ -377,15 +816,7 @@ private:
             bool deserializeRes = deserializeRow(buffer, table, data, pkey);
             if(!deserializeRes) return false;
             callback(data);
-            for(int i = 0; i < table->indexed.size(); ++i){
-                if(!table->indexed[i] || i == index) continue;
-                bool res = true;
-                std::string key = data[i];
-                switch(table->columnTypes[i]){
-                    BTREE_HANDLER(res, table->trees[i].get(), remove(key, pkey))
-                }
-                if(!res) return false;
-            }
+            if(!removeFromIndexes(table, data, pkey, index)) return false;
             table->deleteRow(row);
             ++numRowsRemoved;
             return true;
@@ -397,6 +828,65 @@ private:
         return std::make_pair(res, numRowsRemoved);
     }
 
+    template <typename callback_t>
+    std::pair<bool, row_t> removeByScan(std::shared_ptr<Table>& table, std::vector<PredicateKernel>&& kernels, const callback_t& callback){
+        row_t numRowsRemoved = 0;
+        const auto size = table->columnNames.size();
+        std::vector<std::string> data(size);
+        pkey_t pkey;
+
+        TableScan scan(table.get(), std::move(kernels));
+        while(char* buffer = scan.next()){
+            if(!deserializeRow(buffer, table, data, pkey)) return std::make_pair(false, numRowsRemoved);
+            callback(data);
+            if(!removeFromIndexes(table, data, pkey, -1)) return std::make_pair(false, numRowsRemoved);
+            table->deleteRow(scan.row());
+            ++numRowsRemoved;
+        }
+        return std::make_pair(true, numRowsRemoved);
+    }
+
+    /// Removes rows of a clustered table in range of its key, rows are read from its leaves
+    /// A deleted row only leaves a hole, so range scan goes on past it
+    template <typename callback_t>
+    std::pair<bool, row_t> removeByRange(std::shared_ptr<Table>& table, const KeyRange& range, std::vector<PredicateKernel>&& kernels, const callback_t& callback){
+        row_t numRowsRemoved = 0;
+        const auto size = table->columnNames.size();
+        std::vector<std::string> data(size);
+        pkey_t pkey;
+
+        bool res = table->index(table->getClusterColumn())->rangeScan(range, [&](row_t row)->bool{
+            Cursor cursor(table.get());
+            cursor.row = row;
+            char* buffer = cursor.value();
+            if(buffer == nullptr) return false;
+            for(auto& kernel: kernels){
+                if(!kernel.matches(buffer)) return true;
+            }
+            if(!deserializeRow(buffer, table, data, pkey)) return false;
+            callback(data);
+            if(!removeFromIndexes(table, data, pkey, -1)) return false;
+            table->deleteRow(row);
+            ++numRowsRemoved;
+            return true;
+        });
+        return std::make_pair(res, numRowsRemoved);
+    }
+
+    /// Removes (key, pkey) of given row from every index except skipIndex
+    static bool removeFromIndexes(std::shared_ptr<Table>& table, std::vector<std::string>& data, pkey_t pkey, int skipIndex){
+        for(int i = 0; i < table->indexed.size(); ++i){
+            if(!table->indexed[i] || i == skipIndex) continue;
+            bool res = true;
+            std::string key = data[i];
+            switch(table->columnTypes[i]){
+                BTREE_HANDLER(res, table->trees[i].get(), remove(key, pkey))
+            }
+            if(!res) return false;
+        }
+        return true;
+    }
+
     ExecuteResult executeDrop(std::unique_ptr<QueryStatement>& statement){
         auto res = sharedManager->drop(statement->tableName);
         ErrorHandler::handleTableManagerError(res);
@@ -412,7 +902,7 @@ private:
         int32_t j = 0;
         int32_t size = table->columnNames.size();
         for(int32_t i = 0; i < size; ++i){
-            if(serializeAll || (*indices)[j] == i) {
+            if(serializeAll || (j < indices->size() && (*indices)[j] == i)) {
                 switch (table->columnTypes[i]) {
                     case DataType::Int:
                         try {
@@ -433,7 +923,7 @@ private:
                         break;
 
                     case DataType::Char:
-                        if (data[i].size() != 1) {
+                        if (data[j].size() != 1) {
                             return ExecuteResult::typeMismatch;
                         }
                         memcpy(buffer + offset, &data[j][0], sizeof(char));
@@ -480,7 +970,7 @@ private:
             int j = 0;
             int32_t offset = 0;
             for(int32_t i = 0; i < size; ++i){
-                if(selectAll || indices[j] == i){
+                if(selectAll || (j < indices.size() && indices[j] == i)){
                     switch(table->columnTypes[i]){
                         case DataType::Int:
                             int32_t dataInt;
@@ -1,45 +1,105 @@
 #include "HeaderFiles/ExternalSort.h"
 #include <fstream>
 
-// CONVERT TEMPLATE SECIALIZATION
-template <> inline int convertDataType<int>(const std::string& str)    {  return std::stoi(str);  }
-template <> inline char convertDataType<char>(const std::string& str)  {  return str[0];          }
-template <> inline bool convertDataType<bool>(const std::string& str)  {  return str == "true";   }
-template <> inline float convertDataType<float>(const std::string& str){  return std::stof(str);  }
-template <> inline dbms::string convertDataType<dbms::string>(const std::string& str){  return dbms::string(str);  }
+// ---------------------- IOWorker ----------------------
+
+IOWorker::IOWorker(){
+    thread = std::thread(&IOWorker::run, this);
+}
+
+IOWorker::~IOWorker(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_one();
+    thread.join();
+}
+
+std::future<void> IOWorker::submit(std::function<void()> task){
+    std::packaged_task<void()> packagedTask(std::move(task));
+    auto future = packagedTask.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(packagedTask));
+    }
+    condition.notify_one();
+    return future;
+}
+
+void IOWorker::run(){
+    while(true){
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&](){ return !tasks.empty() || stopping; });
+        // Queued tasks are finished before stopping so no future is left waiting
+        if(tasks.empty()) break;
+        auto task = std::move(tasks.front());
+        tasks.pop();
+        lock.unlock();
+        task();
+    }
+}
 
 
 // ---------------------- SeqPageReader ----------------------
 
 SeqPageReader::~SeqPageReader(){
-    flushRemaining();
+    try{
+        flushRemaining();
+    }
+    catch(...){}
+}
+
+void SeqPageReader::setAsync(bool enable){
+    async = enable;
 }
 
 void SeqPageReader::flushRemaining(){
-    if(readThread.joinable()) readThread.join();
-    if(writeThread.joinable()) writeThread.join();
+    // Buffers and descriptors are released even if pending I/O failed
+    std::exception_ptr error;
+    for(auto* done: {&readDone, &writeDone}){
+        try{
+            waitFor(*done);
+        }
+        catch(...){
+            error = std::current_exception();
+        }
+    }
     if(inFileDescriptor != -1)  ::close(inFileDescriptor);
     if(outFileDescriptor != -1) ::close(outFileDescriptor);
-    primaryOutputBuffer.reset();
+    inFileDescriptor = outFileDescriptor = -1;
+    primaryInputBuffer.reset();
     secondaryInputBuffer.reset();
     primaryOutputBuffer.reset();
     secondaryOutputBuffer.reset();
+    if(error) std::rethrow_exception(error);
 }
 
-void SeqPageReader::initialise(const char* inFileName, const char* outFileName, uint32_t headerOffset){
-    open(inFileName, inFileDescriptor, O_RDONLY);
-    open(outFileName, outFileDescriptor, O_WRONLY);
+void SeqPageReader::initialise(const char* inFileName, const char* outFileName, uint32_t headerOffset,
+                               int64_t readBlockSize_, int64_t writeBlockSize){
+    flushRemaining();
+    readBlockSize = readBlockSize_;
+    if(!open(inFileName, inFileDescriptor, O_RDONLY) || !open(outFileName, outFileDescriptor, O_WRONLY)){
+        throw std::runtime_error("Error opening file");
+    }
+    if(async && !readWorker){
+        readWorker = std::make_unique<IOWorker>();
+        writeWorker = std::make_unique<IOWorker>();
+    }
+    if(!async){
+        readWorker.reset();
+        writeWorker.reset();
+    }
 
-    primaryInputBuffer = std::make_unique<char[]>(seqReadBlockSize);
-    secondaryInputBuffer = std::make_unique<char[]>(seqReadBlockSize);
-    primaryOutputBuffer = std::make_unique<char[]>(seqWriteBlockSize);
-    secondaryOutputBuffer = std::make_unique<char[]>(seqWriteBlockSize);
+    primaryInputBuffer = std::make_unique<char[]>(readBlockSize);
+    secondaryInputBuffer = std::make_unique<char[]>(readBlockSize);
+    primaryOutputBuffer = std::make_unique<char[]>(writeBlockSize);
+    secondaryOutputBuffer = std::make_unique<char[]>(writeBlockSize);
 
     inputFileSize = lseek(inFileDescriptor, 0, SEEK_END);
-    int numDataPagesInInputFile = (inputFileSize - headerOffset) / PAGE_SIZE;
-    int numberPagesSeqBlock = SEQ_READ_BLOCKS * (seqBlockSize / PAGE_SIZE);
-    requiredNumberOfFetches = (numDataPagesInInputFile + numberPagesSeqBlock - 1) / numberPagesSeqBlock;
+    requiredNumberOfFetches = (inputFileSize - headerOffset + readBlockSize - 1) / readBlockSize;
     currentFetchNumber = 0;
+    finishedFetching = finished = false;
 
     lseek(inFileDescriptor, headerOffset, SEEK_SET);
     fetchFromStorage();
@@ -49,7 +109,7 @@ bool SeqPageReader::open(const char* fileName, int& fd, int mode){
     int openFlags = O_CREAT | mode;
     mode_t filePerms = S_IWUSR | S_IRUSR;
     fd = ::open(fileName, openFlags, filePerms);
-    return (fd == -1);
+    return fd != -1;
 }
 
 void SeqPageReader::fetchFromSecondary(){
@@ -60,9 +120,8 @@ void SeqPageReader::fetchFromSecondary(){
 
 void SeqPageReader::fetchFromStorage(){
     if(finishedFetching) return;
-    bufferSize = ::read(inFileDescriptor, secondaryInputBuffer.get(), seqReadBlockSize);
+    bufferSize = ::read(inFileDescriptor, secondaryInputBuffer.get(), readBlockSize);
     if(bufferSize == -1){
-        printf("Error reading file\n");
         throw std::runtime_error("Error reading file");
     }
 
@@ -73,7 +132,9 @@ void SeqPageReader::fetchFromStorage(){
 }
 
 void SeqPageReader::flushOutputToStorage(int64_t outputBuffSize){
-    ssize_t bytesWritten = ::write(outFileDescriptor, secondaryOutputBuffer.get(), outputBuffSize);
+    if(::write(outFileDescriptor, secondaryOutputBuffer.get(), outputBuffSize) != outputBuffSize){
+        throw std::runtime_error("Error writing file");
+    }
 }
 
 void SeqPageReader::flushOutputToSecondary(){
@@ -86,36 +147,172 @@ void SeqPageReader::flushOutputToSecondary(){
 //    return outputFileSize;
 //}
 
-#ifdef SEQ_READ_ASYNC
 void SeqPageReader::fetchInput(){
     if(finished) return;
-    if(readThread.joinable()) readThread.join();
+    waitFor(readDone);
 
     fetchFromSecondary();
     if(finishedFetching) finished = true;
-    else readThread = std::thread (&SeqPageReader::fetchFromStorage, this);
-}
-#else
-void SeqPageReader::fetchInput(){
-    if(finished) return;
-    fetchFromSecondary();
-    if(finishedFetching) finished = true;
+    else if(readWorker) readDone = readWorker->submit([this](){ fetchFromStorage(); });
     else fetchFromStorage();
 }
-#endif
 
-#ifdef SEQ_WRITE_ASYNC
-void SeqPageReader::flushOutput(off_t outputBuffSize){
-    if(writeThread.joinable()) writeThread.join();
+void SeqPageReader::flushOutput(int64_t outputBuffSize){
+    waitFor(writeDone);
     flushOutputToSecondary();
-    writeThread = std::thread(&SeqPageReader::flushOutputToStorage, this, outputBuffSize);
+    if(writeWorker) writeDone = writeWorker->submit([this, outputBuffSize](){ flushOutputToStorage(outputBuffSize); });
+    else flushOutputToStorage(outputBuffSize);
+}
+
+
+// ---------------------- SpillWriter ----------------------
+
+SpillWriter::~SpillWriter(){
+    try{
+        flushRemaining();
+    }
+    catch(...){}
+}
+
+void SpillWriter::setAsync(bool enable){
+    async = enable;
+}
+
+bool SpillWriter::initialise(const char* outFileName, int64_t blockSize_){
+    flushRemaining();
+    blockSize = blockSize_;
+    bufferSize = 0;
+    bytesWritten = 0;
+    outFileDescriptor = ::open(outFileName, O_CREAT | O_WRONLY | O_TRUNC, S_IWUSR | S_IRUSR);
+    if(outFileDescriptor == -1) return false;
+    if(async && !writeWorker) writeWorker = std::make_unique<IOWorker>();
+    if(!async) writeWorker.reset();
+
+    primaryOutputBuffer = std::make_unique<char[]>(blockSize);
+    secondaryOutputBuffer = std::make_unique<char[]>(blockSize);
+    return true;
+}
+
+void SpillWriter::append(const char* data, int64_t size){
+    if(bufferSize + size > blockSize) flushOutput();
+    memcpy(primaryOutputBuffer.get() + bufferSize, data, size);
+    bufferSize += size;
+    bytesWritten += size;
+}
+
+int64_t SpillWriter::size() const{
+    return bytesWritten;
+}
+
+void SpillWriter::flushRemaining(){
+    std::exception_ptr error;
+    try{
+        if(outFileDescriptor != -1 && bufferSize > 0) flushOutput();
+        waitFor(writeDone);
+    }
+    catch(...){
+        error = std::current_exception();
+    }
+    if(outFileDescriptor != -1) ::close(outFileDescriptor);
+    outFileDescriptor = -1;
+    primaryOutputBuffer.reset();
+    secondaryOutputBuffer.reset();
+    if(error) std::rethrow_exception(error);
 }
-#else
-void SeqPageReader::flushOutput(off_t outputBuffSize){
+
+void SpillWriter::flushOutputToStorage(int64_t outputBuffSize){
+    if(::write(outFileDescriptor, secondaryOutputBuffer.get(), outputBuffSize) != outputBuffSize){
+        throw std::runtime_error("Error writing file");
+    }
+}
+
+void SpillWriter::flushOutputToSecondary(){
+    auto temp = std::move(primaryOutputBuffer);
+    primaryOutputBuffer = std::move(secondaryOutputBuffer);
+    secondaryOutputBuffer = std::move(temp);
+}
+
+void SpillWriter::flushOutput(){
+    waitFor(writeDone);
     flushOutputToSecondary();
-    flushOutputToStorage(outputBuffSize);
+    int64_t outputBuffSize = bufferSize;
+    bufferSize = 0;
+    if(writeWorker) writeDone = writeWorker->submit([this, outputBuffSize](){ flushOutputToStorage(outputBuffSize); });
+    else flushOutputToStorage(outputBuffSize);
+}
+
+
+// ---------------------- SpillReader ----------------------
+
+SpillReader::~SpillReader(){
+    try{
+        flushRemaining();
+    }
+    catch(...){}
+}
+
+void SpillReader::setAsync(bool enable){
+    async = enable;
+}
+
+bool SpillReader::initialise(const char* inFileName, int64_t blockSize_){
+    flushRemaining();
+    blockSize = blockSize_;
+    bufferSize = 0;
+    inFileDescriptor = ::open(inFileName, O_RDONLY);
+    if(inFileDescriptor == -1) return false;
+    if(async && !readWorker) readWorker = std::make_unique<IOWorker>();
+    if(!async) readWorker.reset();
+
+    primaryInputBuffer = std::make_unique<char[]>(blockSize);
+    secondaryInputBuffer = std::make_unique<char[]>(blockSize);
+    fetchFromStorage();
+    return true;
+}
+
+void SpillReader::flushRemaining(){
+    std::exception_ptr error;
+    try{
+        waitFor(readDone);
+    }
+    catch(...){
+        error = std::current_exception();
+    }
+    if(inFileDescriptor != -1) ::close(inFileDescriptor);
+    inFileDescriptor = -1;
+    primaryInputBuffer.reset();
+    secondaryInputBuffer.reset();
+    if(error) std::rethrow_exception(error);
+}
+
+void SpillReader::fetchFromSecondary(){
+    auto temp = std::move(primaryInputBuffer);
+    primaryInputBuffer = std::move(secondaryInputBuffer);
+    secondaryInputBuffer = std::move(temp);
+    bufferSize = secondarySize;
+}
+
+void SpillReader::fetchFromStorage(){
+    // Spill files are regular files so read only returns short at end of file
+    secondarySize = 0;
+    while(secondarySize < blockSize){
+        auto len = ::read(inFileDescriptor, secondaryInputBuffer.get() + secondarySize, blockSize - secondarySize);
+        if(len == -1) throw std::runtime_error("Error reading file");
+        if(len == 0) break;
+        secondarySize += len;
+    }
+}
+
+int64_t SpillReader::fetchInput(){
+    if(inFileDescriptor == -1) return 0;
+    waitFor(readDone);
+    fetchFromSecondary();
+    if(bufferSize > 0){
+        if(readWorker) readDone = readWorker->submit([this](){ fetchFromStorage(); });
+        else fetchFromStorage();
+    }
+    return bufferSize;
 }
-#endif
 
 
 // ---------------------- ExtSortPager ----------------------
@@ -126,43 +323,72 @@ ExtSortPager::ExtSortPager(){
 }
 
 ExtSortPager::~ExtSortPager(){
-    flushRemaining();
+    try{
+        flushRemaining();
+    }
+    catch(...){}
+}
+
+void ExtSortPager::setAsync(bool enable){
+    async = enable;
 }
 
 void ExtSortPager::flushRemaining(){
-    if(readThread.joinable()) readThread.join();
-    if(writeThread.joinable()) writeThread.join();
+    std::exception_ptr error;
+    for(auto& future: futures){
+        try{
+            waitFor(future);
+        }
+        catch(...){
+            error = std::current_exception();
+        }
+    }
+    try{
+        waitFor(writeDone);
+    }
+    catch(...){
+        error = std::current_exception();
+    }
     if(inFileDescriptor != -1) ::close(inFileDescriptor);
     if(outFileDescriptor != -1) ::close(outFileDescriptor);
-};
+    inFileDescriptor = outFileDescriptor = -1;
+    if(error) std::rethrow_exception(error);
+}
 
-void ExtSortPager::initialise(const char* inFileName, const char* outFileName, int64_t blocksPerBuffer_, uint64_t offset_, int k_){
+void ExtSortPager::initialise(const char* inFileName, const char* outFileName, std::vector<SortRun> runs_, size_t readSize_, int64_t writeBlockSize){
     flushRemaining();
-    this->blocksPerBuffer = blocksPerBuffer_;
-    this->offset = offset_;
-    this->k = k_;
+    this->runs = std::move(runs_);
+    this->readSize = readSize_;
+    this->offset = runs[0].offset;
+    this->k = runs.size();
 
-    open(inFileName, inFileDescriptor, O_RDONLY);
-    open(outFileName, outFileDescriptor, O_WRONLY);
+    if(!open(inFileName, inFileDescriptor, O_RDONLY) || !open(outFileName, outFileDescriptor, O_WRONLY)){
+        throw std::runtime_error("Error opening file");
+    }
+    if(async && !readWorker){
+        readWorker = std::make_unique<IOWorker>();
+        writeWorker = std::make_unique<IOWorker>();
+    }
+    if(!async){
+        readWorker.reset();
+        writeWorker.reset();
+    }
 
-    fileSize = lseek(inFileDescriptor, 0, SEEK_END);
     lseek(outFileDescriptor, offset, SEEK_SET);
 
-    primaryOutputBuffer     = std::make_unique<char[]>(EXT_WRITE_BLOCKS * seqBlockSize);
-    secondaryOutputBuffer   = std::make_unique<char[]>(EXT_WRITE_BLOCKS * seqBlockSize);
-    finishedFetchingAll = false;
+    primaryOutputBuffer     = std::make_unique<char[]>(writeBlockSize);
+    secondaryOutputBuffer   = std::make_unique<char[]>(writeBlockSize);
 
+    primaryInputBuffer.resize(k);
+    secondaryInputBuffer.resize(k);
+    futures.clear();
+    futures.resize(k);
+    timesFetched.assign(k, 0);
     for(int buffNo = 0; buffNo < k; ++buffNo){
-        primaryInputBuffer[buffNo]      = std::make_unique<char[]>(EXT_READ_BLOCKS * seqBlockSize);
-        secondaryInputBuffer[buffNo]    = std::make_unique<char[]>(EXT_READ_BLOCKS * seqBlockSize);
-        timesFetched[buffNo]            = 0;
+        primaryInputBuffer[buffNo]      = std::make_unique<char[]>(readSize);
+        secondaryInputBuffer[buffNo]    = std::make_unique<char[]>(readSize);
         fetchFromStorage(buffNo);
     }
-
-
-    #ifdef EXT_READ_ASYNC
-        readThread = std::thread(&ExtSortPager::storageFetcher, this);
-    #endif
 }
 
 bool ExtSortPager::open(const char* fileName, int& fd, int mode){
@@ -179,16 +405,18 @@ void ExtSortPager::fetchFromSecondary(int bufferNo){
 }
 
 void ExtSortPager::fetchFromStorage(int bufferNo){
-    uint64_t offset_ = this->offset + (bufferNo * blocksPerBuffer + timesFetched[bufferNo]) * EXT_READ_BLOCKS * extBlockSize;
-    if(offset_ > fileSize) return;
-    lseek(inFileDescriptor, offset_, SEEK_SET);
-    auto len = ::read(inFileDescriptor, secondaryInputBuffer[bufferNo].get(), readSize);
-    if(len == -1) throw std::runtime_error("Error reading file");
+    uint64_t fetched = timesFetched[bufferNo] * readSize;
+    if(fetched >= runs[bufferNo].bytes) return;
+    size_t size = std::min<uint64_t>(readSize, runs[bufferNo].bytes - fetched);
+    auto len = pread(inFileDescriptor, secondaryInputBuffer[bufferNo].get(), size, runs[bufferNo].offset + fetched);
+    if(len != (ssize_t)size) throw std::runtime_error("Error reading file");
     ++timesFetched[bufferNo];
 }
 
 void ExtSortPager::flushOutputToStorage(uint64_t outputBuffSize){
-    ssize_t bytesWritten = ::write(outFileDescriptor, secondaryOutputBuffer.get(), outputBuffSize);
+    if(::write(outFileDescriptor, secondaryOutputBuffer.get(), outputBuffSize) != (ssize_t)outputBuffSize){
+        throw std::runtime_error("Error writing file");
+    }
 }
 
 void ExtSortPager::flushOutputToSecondary(){
@@ -197,84 +425,101 @@ void ExtSortPager::flushOutputToSecondary(){
     secondaryOutputBuffer = std::move(temp);
 }
 
-#ifdef EXT_READ_ASYNC
-void ExtSortPager::storageFetcher(){
-    while(true){
-        std::unique_lock<std::mutex> lock(queueMutex);
-        condition.wait(lock, [&](){return !fillRequests.empty() || finishedFetchingAll;});
-        if(finishedFetchingAll) break;
-        auto request = std::move(fillRequests.front());
-        fillRequests.pop();
-        lock.unlock();
-        fetchFromStorage(request.second);
-        request.first.set_value(true);
-    }
-}
-
 void ExtSortPager::fetchInput(int bufferNo, bool fetchMore){
-    if(futures[bufferNo].valid()) futures[bufferNo].get();
+    waitFor(futures[bufferNo]);
     fetchFromSecondary(bufferNo);
 
     if(fetchMore){
-        {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            std::promise<bool> fetchPromise;
-            futures[bufferNo] = fetchPromise.get_future();
-            fillRequests.emplace(std::move(fetchPromise), bufferNo);
-        }
-        condition.notify_one();
+        if(readWorker) futures[bufferNo] = readWorker->submit([this, bufferNo](){ fetchFromStorage(bufferNo); });
+        else fetchFromStorage(bufferNo);
     }
 }
 
-void ExtSortPager::endFetching(){
-    finishedFetchingAll = true;
-    condition.notify_one();
+void ExtSortPager::flushOutput(off_t outputBuffSize){
+    waitFor(writeDone);
+    flushOutputToSecondary();
+    if(writeWorker) writeDone = writeWorker->submit([this, outputBuffSize](){ flushOutputToStorage(outputBuffSize); });
+    else flushOutputToStorage(outputBuffSize);
 }
 
-#else
-void ExtSortPager::fetchInput(int bufferNo, bool fetchMore){
-    fetchFromSecondary(bufferNo);
-    if(fetchMore) fetchFromStorage(bufferNo);
+// ---------------------- LoserTree ----------------------
+
+LoserTree::LoserTree(int k_, int32_t keyWidth_): losers(k_, 0), heads(k_, nullptr){
+    k = k_;
+    keyWidth = keyWidth_;
 }
 
-void ExtSortPager::endFetching() {}
-#endif
+void LoserTree::set(int source, const char* head){
+    heads[source] = head;
+}
 
-#ifdef EXT_WRITE_ASYNC
-void ExtSortPager::flushOutput(off_t outputBuffSize){
-    if(writeThread.joinable()) writeThread.join();
-    flushOutputToSecondary();
-    writeThread = std::thread (&ExtSortPager::flushOutputToStorage, this, outputBuffSize);
+bool LoserTree::before(int a, int b) const{
+    if(heads[a] == nullptr) return false;
+    if(heads[b] == nullptr) return true;
+    int res = memcmp(heads[a], heads[b], keyWidth);
+    return res < 0 || (res == 0 && a < b);
 }
-#else
-void ExtSortPager::flushOutput(off_t outputBuffSize){
-    flushOutputToSecondary();
-    flushOutputToStorage(outputBuffSize);
+
+/// Nodes are numbered like a heap, leaf of source i is node k + i
+/// Returns winner of subtree at node
+int LoserTree::build(int node){
+    if(node >= k) return node - k;
+    int left = build(2 * node);
+    int right = build(2 * node + 1);
+    if(before(left, right)){
+        losers[node] = right;
+        return left;
+    }
+    losers[node] = left;
+    return right;
+}
+
+void LoserTree::build(){
+    losers[0] = (k == 1) ? 0 : build(1);
+}
+
+bool LoserTree::empty() const{
+    return heads[losers[0]] == nullptr;
+}
+
+int LoserTree::winner() const{
+    return losers[0];
+}
+
+const char* LoserTree::top() const{
+    return heads[losers[0]];
+}
+
+void LoserTree::replace(const char* head){
+    int current = losers[0];
+    heads[current] = head;
+    for(int node = (current + k) / 2; node > 0; node /= 2){
+        if(before(losers[node], current)) std::swap(losers[node], current);
+    }
+    losers[0] = current;
 }
-#endif
 
-template <typename key_t>
-void convertToText(const std::string& infileName, const std::string& outFileName, int keySize, row_t rowCount){
+void convertToText(const std::string& infileName, const std::string& outFileName, const SortKey& key, row_t rowCount){
     int fd = open(infileName.c_str(), O_RDONLY);
     std::ofstream fout(outFileName);
 
-    char* buffer = new char[seqBlockSize];
+    const int64_t blockSize = (1 << 20);
+    char* buffer = new char[blockSize];
 
-    int rowSize = (keySize + sizeof(row_t));
-    row_t rowInOneGo = seqBlockSize / rowSize;
+    int rowSize = (key.width + sizeof(row_t));
+    row_t rowInOneGo = blockSize / rowSize;
     uint64_t readSize = rowInOneGo * rowSize;
     row_t row = 0;
     row_t reads = (rowCount + rowInOneGo - 1) / rowInOneGo;
-    key_t key;
     for(int i = 0; i < reads; ++i){
         ::read(fd, buffer, readSize);
         if(i == reads - 1) rowInOneGo = rowCount - row;
         uint64_t offset = 0;
 
         for(int j = 0; j < rowInOneGo; ++j){
-            memcpy(&key, buffer + offset, keySize);
-            offset += (keySize + sizeof(row_t));
-            fout << key << "\n";
+            for(auto& value: key.decode(buffer + offset)) fout << value << " ";
+            fout << "\n";
+            offset += rowSize;
             ++row;
         }
     }
@@ -286,42 +531,66 @@ void convertToText(const std::string& infileName, const std::string& outFileName
 
 
 // ---------------------- ExternalSort ----------------------
-template <typename key_t>
-ExternalSort<key_t>::ExternalSort(const std::string& databaseName_, const std::string& fileName_, const std::string& finalSortedFileName_, int numRows_, int* rowStack)
-:deletedRows(rowStack[0]){
+ExternalSort::ExternalSort(const std::string& databaseName_, const std::string& fileName_, const std::string& finalSortedFileName_, row_t numRows_, row_t* rowStack,
+                           const SortOptions& options_)
+:ExternalSort(databaseName_ + "/" + fileName_, finalSortedFileName_, numRows_,
+              std::vector<row_t>(rowStack + 1, rowStack + 1 + rowStack[0]), options_){}
+
+ExternalSort::ExternalSort(const std::string& tableFileName, const std::string& finalSortedFileName_, row_t numRows_, std::vector<row_t> deletedRows_,
+                           const SortOptions& options_)
+:deletedRows(std::move(deletedRows_)), options(options_){
     this->finalSortedFileName   = finalSortedFileName_;
-    this->fileName              = databaseName_ + "/" + fileName_;
+    this->fileName              = tableFileName;
     this->numRows               = numRows_;
-    for(int i = 0; i < rowStack[0]; ++i){
-        deletedRows[i] = rowStack[i + 1];
-    }
     std::sort(deletedRows.begin(), deletedRows.end());
-    this->partiallySortedFileName[0] = std::string("extSortTemp/") + "_0_" + fileName_;
-    this->partiallySortedFileName[1] = std::string("extSortTemp/") + "_1_" + fileName_;
+
+    // Runs are named after table file so sorts of different tables don't clash
+    std::string baseName = std::filesystem::path(tableFileName).filename().string();
+    std::filesystem::create_directories(options.tempDirectory);
+    this->partiallySortedFileName[0] = options.tempDirectory + "/_0_" + baseName;
+    this->partiallySortedFileName[1] = options.tempDirectory + "/_1_" + baseName;
+
+    int64_t memory      = std::max<int64_t>(options.memoryBudget, MIN_SORT_MEMORY);
+    readBlockSize       = std::max<int64_t>(memory / 4 / pageSize, 1) * pageSize;
+    writeBlockSize      = memory / 8;
+    sortBufferSize      = memory / 4;
+    mergeInputMemory    = memory - 2 * writeBlockSize;
+    maxMergeReadSize    = memory / 16;
+    seqReader.setAsync(options.asyncIO);
+    pager.setAsync(options.asyncIO);
+}
+
+int32_t ExternalSort::getRecordSize() const{
+    return recordSize;
+}
+
+void ExternalSort::setPageDecoder(int32_t rowsPerPage, PageDecoder decoder){
+    decodedRowsPerPage = rowsPerPage;
+    pageDecoder = std::move(decoder);
 }
 
-template <typename key_t>
-void ExternalSort<key_t>::sort(int rowSize_, int columnOffset_, int32_t keySize_, uint32_t headerOffset){
+void ExternalSort::setPageSize(int32_t pageSize_){
+    pageSize = pageSize_;
+    readBlockSize = std::max<int64_t>(std::max<int64_t>(options.memoryBudget, MIN_SORT_MEMORY) / 4 / pageSize, 1) * pageSize;
+}
+
+void ExternalSort::sort(int rowSize_, const SortKey& key_, uint32_t headerOffset){
     rowSize             = rowSize_;
-    columnOffset        = columnOffset_;
-    keySize             = keySize_;
-    rowsPerInputBlock   = EXT_READ_BLOCKS * extBlockSize / (sizeof(row_t) + keySize);
-    rowsPerOutputBlock  = EXT_WRITE_BLOCKS * extBlockSize / (sizeof(row_t) + keySize);
+    key                 = key_;
+    recordSize          = key.width + sizeof(row_t);
+    rowsPerOutputBlock  = writeBlockSize / recordSize;
     fileIdx             = 0;
+    runs.clear();
     getData(headerOffset);
-    // convertToText<key_t>(partiallySortedFileName[0], "initial.txt", keySize, numRows);
+    // convertToText(partiallySortedFileName[0], "initial.txt", key, numRows);
 
-    pager.readSize = rowsPerInputBlock * (sizeof(row_t) + keySize);
-    row_t sortedRows = rowsInSingleBlock;
-    while(sortedRows < numRows){
-        int sortedRowsInOneMerge = sortedRows * EXTERNAL_SORTING_K;
-        int numMerges = (numRows + sortedRowsInOneMerge - 1) / sortedRowsInOneMerge;
-
-        for(int mergeIdx = 0; mergeIdx < numMerges; ++mergeIdx){
-            kWayMerge(sortedRows, mergeIdx);
+    while(runs.size() > 1){
+        int fanIn = mergeFanIn();
+        std::vector<SortRun> merged;
+        for(size_t first = 0; first < runs.size(); first += fanIn){
+            merged.push_back(kWayMerge(first, std::min<size_t>(fanIn, runs.size() - first), fanIn));
         }
-
-        sortedRows *= EXTERNAL_SORTING_K;
+        runs = std::move(merged);
         fileIdx = 1 - fileIdx;
     }
 
@@ -329,156 +598,139 @@ void ExternalSort<key_t>::sort(int rowSize_, int columnOffset_, int32_t keySize_
     std::filesystem::rename(partiallySortedFileName[fileIdx], finalSortedFileName);
 }
 
-template <typename key_t>
-void ExternalSort<key_t>::getData(uint32_t headerOffset){
-    seqReader.initialise(fileName.c_str(), partiallySortedFileName[0].c_str(), headerOffset);
+void ExternalSort::getData(uint32_t headerOffset){
+    seqReader.initialise(fileName.c_str(), partiallySortedFileName[0].c_str(), headerOffset, readBlockSize, writeBlockSize);
     initReader();
-    initWriter();
-
-    key_t key;
-    auto nextDeletedRow = deletedRows.begin();
+    if(options.replacementSelection){
+        selectRuns();
+    }
+    else{
+        initWriter();
 
-    while(readNextRow(key)){
-        // Check if this row is deleted
-        if(nextDeletedRow != deletedRows.end() && currentReadRow == *nextDeletedRow){
-            ++nextDeletedRow;
-        }
-        else{
-            writeNextRow(key, currentReadRow);
+        const char* row;
+        row_t rowNo;
+        while(readNextLiveRow(row, rowNo)){
+            writeNextRow(row, rowNo);
         }
-    }
 
-    // Write Remaining Data
-    sortBufferAndWrite(currentWriteRowInSortingBuffer);
+        // Write Remaining Data
+        sortBufferAndWrite(currentWriteRowInSortingBuffer);
+    }
     seqReader.flushRemaining();
+
+    // Only rows which are not deleted are merged
+    numRows = currentWriteRow;
+}
+
+int ExternalSort::mergeFanIn() const{
+    if(options.fanIn > 0) return std::max<int>(2, std::min<size_t>(options.fanIn, runs.size()));
+    int maxFanIn = std::max<int64_t>(2, mergeInputMemory / (2 * MIN_MERGE_READ_SIZE));
+    if(runs.size() <= maxFanIn) return runs.size();
+
+    // Same number of passes as maxFanIn but with bigger input buffers
+    int passes = std::ceil(std::log(runs.size()) / std::log(maxFanIn));
+    return std::min<int>(maxFanIn, std::ceil(std::pow(runs.size(), 1.0 / passes)));
 }
 
-template <typename key_t>
-void ExternalSort<key_t>::kWayMerge(row_t sortedRows, int64_t mergeIdx){
-    int64_t timesFetchingReqd = sortedRows / rowsPerInputBlock;
-    row_t rowsProcessed = mergeIdx * sortedRows * EXTERNAL_SORTING_K;
-    row_t rowsToProcess = std::min(sortedRows * EXTERNAL_SORTING_K, numRows - rowsProcessed);
-    int k = (rowsToProcess + sortedRows - 1) / sortedRows;
-    uint64_t offset = rowsProcessed * (sizeof(row_t) + keySize);
+SortRun ExternalSort::kWayMerge(size_t first, size_t count, int fanIn){
+    std::vector<SortRun> inputs(runs.begin() + first, runs.begin() + first + count);
+    int k = count;
 
+    // Every input run has a double buffer of readSize bytes, a multiple of recordSize
+    int64_t readSize = std::min<int64_t>(maxMergeReadSize, mergeInputMemory / (2 * fanIn));
+    row_t rowsPerInputBlock = std::max<int64_t>(1, readSize / recordSize);
     pager.initialise(partiallySortedFileName[fileIdx].c_str(),
                      partiallySortedFileName[1 - fileIdx].c_str(),
-                     timesFetchingReqd, offset, k);
+                     inputs, rowsPerInputBlock * recordSize, rowsPerOutputBlock * recordSize);
 
-    std::vector<data_t> buffers[k];
-    std::vector<data_t> outputBuffer(rowsPerOutputBlock);
-    row_t bufferIdx[k];
-    row_t remRows[k];
+    // Records are compared where they lie in input buffers
+    LoserTree tree(k, key.width);
+    std::vector<row_t> bufferIdx(k);
+    std::vector<row_t> remRows(k);
     row_t outputBufferIdx = 0;
-    heap_t heap;
+    uint64_t mergedBytes = 0;
 
     for(int buffNo = 0; buffNo < k; ++buffNo){
-        remRows[buffNo] = (buffNo == k - 1) ? (rowsToProcess - (k - 1) * sortedRows) : sortedRows;
-
-        // Deserialize Input Buffer
-        buffers[buffNo].resize(rowsPerInputBlock);
-        pager.fetchInput(buffNo, (remRows[buffNo] - rowsPerInputBlock > 0));
-        auto ipBuffer = pager.primaryInputBuffer[buffNo].get();
-        uint64_t ipOffset = 0;
-        for(int i = 0; i < rowsPerInputBlock; ++i){
-            memcpy(&buffers[buffNo][i].key, ipBuffer + ipOffset, keySize);
-            ipOffset += keySize;
-            memcpy(&buffers[buffNo][i].row, ipBuffer + ipOffset, sizeof(row_t));
-            ipOffset += sizeof(row_t);
-        }
+        remRows[buffNo] = inputs[buffNo].bytes / recordSize;
+        mergedBytes += inputs[buffNo].bytes;
 
-        // Add Initial Values to heap
-        heap.emplace(buffers[buffNo][0], buffNo);
+        // Add Initial Values to tree
+        pager.fetchInput(buffNo, (remRows[buffNo] > rowsPerInputBlock));
+        tree.set(buffNo, pager.primaryInputBuffer[buffNo].get());
         bufferIdx[buffNo] = 1;
         --remRows[buffNo];
     }
+    tree.build();
 
-    while(!heap.empty()){
-        auto next = heap.top();
-        heap.pop();
-
-        int buffNo = next.second;
-        outputBuffer[outputBufferIdx++] = std::move(next.first);
+    while(!tree.empty()){
+        int buffNo = tree.winner();
+        const char* record = tree.top();
+        memcpy(pager.primaryOutputBuffer.get() + outputBufferIdx * recordSize, record, recordSize);
+        ++outputBufferIdx;
 
         if(outputBufferIdx == rowsPerOutputBlock){
-            // Serialize Output
-            auto opBuffer = pager.primaryOutputBuffer.get();
-            uint64_t opOffset = 0;
-            for(int i = 0; i < rowsPerOutputBlock; ++i){
-                memcpy(opBuffer + opOffset, &outputBuffer[i].key, keySize);
-                opOffset += keySize;
-                memcpy(opBuffer + opOffset, &outputBuffer[i].row, sizeof(row_t));
-                opOffset += sizeof(row_t);
-            }
-
-            pager.flushOutput(opOffset);
+            pager.flushOutput(outputBufferIdx * recordSize);
             outputBufferIdx = 0;
         }
 
+        const char* next = nullptr;
         if(remRows[buffNo] > 0){
             if(bufferIdx[buffNo] == rowsPerInputBlock){
-                bool fetchMore = (remRows[buffNo] - rowsPerInputBlock > 0);
-                pager.fetchInput(buffNo, fetchMore);
-                auto ipBuffer = pager.primaryInputBuffer[buffNo].get();
-                uint64_t ipOffset = 0;
-                for(int i = 0; i < rowsPerInputBlock; ++i){
-                    memcpy(&buffers[buffNo][i].key, ipBuffer + ipOffset, keySize);
-                    ipOffset += keySize;
-                    memcpy(&buffers[buffNo][i].row, ipBuffer + ipOffset, sizeof(row_t));
-                    ipOffset += sizeof(row_t);
-                }
+                pager.fetchInput(buffNo, (remRows[buffNo] > rowsPerInputBlock));
+                next = pager.primaryInputBuffer[buffNo].get();
                 bufferIdx[buffNo] = 0;
             }
-
-            heap.emplace(buffers[buffNo][bufferIdx[buffNo]], buffNo);
+            else{
+                next = record + recordSize;
+            }
             ++bufferIdx[buffNo];
             --remRows[buffNo];
         }
+        tree.replace(next);
     }
 
     if(outputBufferIdx != 0){
-        auto opBuffer = pager.primaryOutputBuffer.get();
-        uint64_t opOffset = 0;
-        for(int i = 0; i < outputBufferIdx; ++i){
-            memcpy(opBuffer + opOffset, &outputBuffer[i].key, keySize);
-            opOffset += keySize;
-            memcpy(opBuffer + opOffset, &outputBuffer[i].row, sizeof(row_t));
-            opOffset += sizeof(row_t);
-        }
-        pager.flushOutput(opOffset);
+        pager.flushOutput(outputBufferIdx * recordSize);
     }
-    pager.endFetching();
     pager.flushRemaining();
+    return {inputs[0].offset, mergedBytes};
 }
 
-template <typename key_t>
-void ExternalSort<key_t>::initReader(){
+void ExternalSort::initReader(){
     readOffset = 0;
     currentReadBufferNumber = 0;
     currentReadPageNumber = 0;
     currentReadRowInPage = 0;
     currentReadRow = 0;
-    readOffset = columnOffset;
+    nextDeletedRow = 0;
+    pendingFetch = false;
 
-    rowsInSinglePage = PAGE_SIZE / rowSize;
-    numPagesInInputBuffer = SEQ_READ_BLOCKS * (seqBlockSize / PAGE_SIZE);
+    rowsInSinglePage = pageDecoder ? decodedRowsPerPage : pageSize / rowSize;
+    if(pageDecoder) decodedPage = std::make_unique<char[]>((int64_t)decodedRowsPerPage * rowSize);
+    numPagesInInputBuffer = readBlockSize / pageSize;
 
     seqReader.fetchInput();
     inputBuffer = seqReader.primaryInputBuffer.get();
 }
 
-template <typename key_t>
-bool ExternalSort<key_t>::readNextRow(key_t& key){
+bool ExternalSort::readNextRow(const char*& row){
     // Check if all rows are read
     if(currentReadRow == numRows){
         return false;
     }
 
-    // Read data at read offset
-    memcpy(&key, inputBuffer + readOffset, keySize);
-    // TODO: This will cause bug with dbms::string
-    //       Create different set of functions for dbms::string using flexible array member
+    // Buffer is swapped only after previous row was copied to sorting buffer
+    if(pendingFetch){
+        seqReader.fetchInput();
+        inputBuffer = seqReader.primaryInputBuffer.get();
+        pendingFetch = false;
+    }
 
+    if(pageDecoder){
+        if(currentReadRowInPage == 0) pageDecoder(inputBuffer + currentReadPageNumber * pageSize, decodedPage.get());
+        row = decodedPage.get() + (int64_t)currentReadRowInPage * rowSize;
+    }
+    else row = inputBuffer + readOffset;
     readOffset += rowSize;
     ++currentReadRowInPage;
     ++currentReadRow;
@@ -487,33 +739,134 @@ bool ExternalSort<key_t>::readNextRow(key_t& key){
     if(currentReadRowInPage == rowsInSinglePage){
         currentReadRowInPage = 0;
         ++currentReadPageNumber;
-        readOffset = currentReadPageNumber * PAGE_SIZE + columnOffset;
+        readOffset = currentReadPageNumber * pageSize;
     }
 
     // Change Input Buffer
     if(currentReadPageNumber == numPagesInInputBuffer){
         ++currentReadBufferNumber;
         currentReadPageNumber = 0;
-        readOffset = columnOffset;
-        seqReader.fetchInput();
-        inputBuffer = seqReader.primaryInputBuffer.get();
+        readOffset = 0;
+        pendingFetch = true;
     }
 
     return true;
 }
 
-template <typename key_t>
-void ExternalSort<key_t>::initWriter(){
+void ExternalSort::initWriter(){
     currentWriteRowInSortingBuffer = 0;
     currentWriteRow = 0;
+    sortingThreads = (options.threads > 0) ? options.threads : std::max(1u, std::thread::hardware_concurrency());
 
-    rowsInSingleBlock = SORTING_BUFFER_BLOCKS * seqBlockSize / (keySize + sizeof(row_t));
+    // Keys up to 8 bytes live entirely in prefix so no record buffer is needed, but radix sort needs scratch entries
+    int64_t bytesPerRow = sizeof(SortEntry) + ((key.width > 8) ? recordSize : sizeof(SortEntry));
+    rowsInSingleBlock = sortBufferSize / bytesPerRow;
     parsedData.resize(rowsInSingleBlock);
+    if(key.width <= 8) radixBuffer.resize(rowsInSingleBlock);
+    if(key.width > 8) sortBuffer = std::make_unique<char[]>((int64_t)rowsInSingleBlock * recordSize);
 }
 
-template <typename key_t>
-void ExternalSort<key_t>::writeNextRow(key_t& key, row_t row){
-    parsedData[currentWriteRowInSortingBuffer] = data_t(std::move(key), row);
+bool ExternalSort::readNextLiveRow(const char*& row, row_t& rowNo){
+    while(readNextRow(row)){
+        // readNextRow has already moved to next row
+        rowNo = currentReadRow - 1;
+
+        // Check if this row is deleted
+        if(nextDeletedRow < deletedRows.size() && rowNo == deletedRows[nextDeletedRow]){
+            ++nextDeletedRow;
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+/// First 8 bytes of key as big endian integer so integer order is memcmp order
+uint64_t ExternalSort::prefixOf(const char* record) const{
+    uint64_t prefix = 0;
+    for(int32_t i = 0; i < 8; ++i){
+        prefix = (prefix << 8) | (uint8_t)((i < key.width) ? record[i] : 0);
+    }
+    return prefix;
+}
+
+void ExternalSort::selectRuns(){
+    currentWriteRow = 0;
+    int64_t capacity = std::max<int64_t>(1, sortBufferSize / (recordSize + sizeof(SelectionEntry)));
+    sortBuffer = std::make_unique<char[]>(capacity * recordSize);
+    auto recordOf = [&](const SelectionEntry& entry){ return sortBuffer.get() + (int64_t)entry.slot * recordSize; };
+
+    // Top of heap is smallest record of lowest run
+    auto after = [&](const SelectionEntry& a, const SelectionEntry& b){
+        if(a.run != b.run) return a.run > b.run;
+        if(a.prefix != b.prefix) return a.prefix > b.prefix;
+        if(key.width <= 8) return false;
+        return memcmp(recordOf(a) + 8, recordOf(b) + 8, key.width - 8) > 0;
+    };
+    std::vector<SelectionEntry> heap;
+    heap.reserve(capacity);
+    auto load = [&](const char* row, row_t rowNo, row_t slot){
+        char* record = sortBuffer.get() + (int64_t)slot * recordSize;
+        key.encode(row, record);
+        memcpy(record + key.width, &rowNo, sizeof(row_t));
+        return record;
+    };
+    auto push = [&](const char* record, row_t slot, uint32_t run){
+        heap.push_back({prefixOf(record), run, slot});
+        std::push_heap(heap.begin(), heap.end(), after);
+    };
+
+    const char* row;
+    row_t rowNo;
+    while((int64_t)heap.size() < capacity && readNextLiveRow(row, rowNo)){
+        row_t slot = heap.size();
+        push(load(row, rowNo, slot), slot, 0);
+    }
+
+    row_t rowsPerOutputBuffer = writeBlockSize / recordSize;
+    row_t outputIdx = 0;
+    uint32_t currentRun = 0;
+    SortRun run = {0, 0};
+    while(!heap.empty()){
+        std::pop_heap(heap.begin(), heap.end(), after);
+        SelectionEntry top = heap.back();
+        heap.pop_back();
+
+        if(top.run != currentRun){
+            runs.push_back(run);
+            run = {run.offset + run.bytes, 0};
+            currentRun = top.run;
+        }
+
+        if(outputIdx == rowsPerOutputBuffer){
+            seqReader.flushOutput(outputIdx * recordSize);
+            outputIdx = 0;
+        }
+        char* written = seqReader.primaryOutputBuffer.get() + (int64_t)outputIdx * recordSize;
+        memcpy(written, recordOf(top), recordSize);
+        ++outputIdx;
+        run.bytes += recordSize;
+        ++currentWriteRow;
+
+        // Freed slot takes next row, it joins current run only if it doesn't come before written record
+        if(readNextLiveRow(row, rowNo)){
+            const char* record = load(row, rowNo, top.slot);
+            push(record, top.slot, (memcmp(record, written, key.width) < 0) ? currentRun + 1 : currentRun);
+        }
+    }
+    if(run.bytes > 0) runs.push_back(run);
+    if(outputIdx > 0) seqReader.flushOutput(outputIdx * recordSize);
+}
+
+void ExternalSort::writeNextRow(const char* row, row_t rowNo){
+    char keyBuffer[8] = {0};
+    char* record = keyBuffer;
+    if(key.width > 8){
+        record = sortBuffer.get() + (int64_t)currentWriteRowInSortingBuffer * recordSize;
+        memcpy(record + key.width, &rowNo, sizeof(row_t));
+    }
+    key.encode(row, record);
+    parsedData[currentWriteRowInSortingBuffer] = {prefixOf(record), (key.width > 8) ? currentWriteRowInSortingBuffer : rowNo};
 
     ++currentWriteRowInSortingBuffer;
     ++currentWriteRow;
@@ -525,41 +878,104 @@ void ExternalSort<key_t>::writeNextRow(key_t& key, row_t row){
     }
 }
 
-template <typename key_t>
-void ExternalSort<key_t>::sortBufferAndWrite(row_t rows){
-    std::sort(parsedData.begin(), parsedData.begin() + rows);
+void ExternalSort::writeEntry(const SortEntry& entry, char* buffer){
+    if(key.width > 8){
+        memcpy(buffer, sortBuffer.get() + (int64_t)entry.index * recordSize, recordSize);
+        return;
+    }
+    for(int32_t i = 0; i < key.width; ++i){
+        buffer[i] = (char)(entry.prefix >> (8 * (7 - i)));
+    }
+    memcpy(buffer + key.width, &entry.index, sizeof(row_t));
+}
+
+bool ExternalSort::entryBefore(const SortEntry& a, const SortEntry& b) const{
+    if(a.prefix != b.prefix) return a.prefix < b.prefix;
+    if(key.width <= 8) return false;
+    const char* records = sortBuffer.get();
+    return memcmp(records + (int64_t)a.index * recordSize + 8, records + (int64_t)b.index * recordSize + 8, key.width - 8) < 0;
+}
 
-    row_t size = SEQ_WRITE_BLOCKS * seqBlockSize / (sizeof(row_t) + keySize);
-    int fullWrites = rows / size;
-    for(int writeNo = 0; writeNo < fullWrites; ++writeNo){
-        auto buffer = seqReader.primaryOutputBuffer.get();
-        uint64_t offset = 0;
-        row_t start = writeNo * size;
-        row_t end = start + size;
-        for(int i = start; i < end; ++i){
-            memcpy(buffer + offset,  &parsedData[i].key, keySize);
-            // TODO: This won't work for strings.
-            offset += keySize;
-            memcpy(buffer + offset,  &parsedData[i].row, sizeof(row_t));
-            offset += sizeof(row_t);
+void ExternalSort::radixSort(SortEntry* begin, SortEntry* end, SortEntry* temp) const{
+    size_t n = end - begin;
+    if(n <= 1) return;
+    SortEntry* from = begin;
+    SortEntry* to = temp;
+
+    // Key bytes are left aligned in prefix so least significant key byte is at shift 8 * (8 - width)
+    for(int shift = 8 * (8 - key.width); shift < 64; shift += 8){
+        size_t count[256] = {0};
+        for(SortEntry* entry = from; entry != from + n; ++entry) ++count[(entry->prefix >> shift) & 0xFF];
+        if(count[(from->prefix >> shift) & 0xFF] == n) continue;
+
+        size_t position = 0;
+        for(size_t& c: count){
+            size_t digitCount = c;
+            c = position;
+            position += digitCount;
         }
-        seqReader.flushOutput(offset);
+        for(SortEntry* entry = from; entry != from + n; ++entry){
+            to[count[(entry->prefix >> shift) & 0xFF]++] = *entry;
+        }
+        std::swap(from, to);
+    }
+    if(from != begin) std::copy(from, from + n, begin);
+}
+
+void ExternalSort::sortBufferAndWrite(row_t rows){
+    if(rows == 0) return;
+    uint64_t runOffset = runs.empty() ? 0 : runs.back().offset + runs.back().bytes;
+    runs.push_back({runOffset, (uint64_t)rows * recordSize});
+
+    auto before = [this](const SortEntry& a, const SortEntry& b){ return entryBefore(a, b); };
+
+    // Buffer is cut into one chunk per thread, chunks are sorted in parallel
+    // Small buffers are not worth starting threads for
+    int chunks = std::max<int64_t>(1, std::min<int64_t>(sortingThreads, rows / MIN_ROWS_PER_SORTING_THREAD));
+    std::vector<row_t> bounds(chunks + 1);
+    for(int i = 0; i <= chunks; ++i) bounds[i] = (int64_t)rows * i / chunks;
+
+    auto sortChunk = [&](int i){
+        if(key.width <= 8){
+            radixSort(parsedData.data() + bounds[i], parsedData.data() + bounds[i + 1], radixBuffer.data() + bounds[i]);
+        }
+        else{
+            std::sort(parsedData.begin() + bounds[i], parsedData.begin() + bounds[i + 1], before);
+        }
+    };
+    std::vector<std::thread> workers;
+    for(int i = 1; i < chunks; ++i){
+        workers.emplace_back(sortChunk, i);
+    }
+    sortChunk(0);
+    for(auto& worker: workers) worker.join();
+
+    // Sorted chunks are merged while records are written out
+    // Heap holds (position of next entry, chunk) of every chunk, top is smallest
+    auto greater = [&](const std::pair<row_t, int>& a, const std::pair<row_t, int>& b){
+        return before(parsedData[b.first], parsedData[a.first]);
+    };
+    std::priority_queue<std::pair<row_t, int>, std::vector<std::pair<row_t, int>>, decltype(greater)> heap(greater);
+    for(int i = 0; i < chunks; ++i){
+        if(bounds[i] < bounds[i + 1]) heap.emplace(bounds[i], i);
     }
+    auto nextEntry = [&]()->row_t{
+        if(chunks == 1) return bounds[0]++;
+        auto next = heap.top();
+        heap.pop();
+        if(next.first + 1 < bounds[next.second + 1]) heap.emplace(next.first + 1, next.second);
+        return next.first;
+    };
 
-    row_t remaining = rows % size;
-    if(remaining > 0) {
+    row_t size = writeBlockSize / recordSize;
+    for(row_t start = 0; start < rows; start += size){
+        row_t end = std::min(rows, start + size);
         auto buffer = seqReader.primaryOutputBuffer.get();
         uint64_t offset = 0;
-        row_t start = fullWrites * size;
-        row_t end = start + remaining;
-        for(int i = start; i < end; ++i){
-            memcpy(buffer + offset,  &parsedData[i].key, keySize);
-            // TODO: This won't work for strings.
-            offset += keySize;
-            memcpy(buffer + offset,  &parsedData[i].row, sizeof(row_t));
-            offset += sizeof(row_t);
+        for(row_t i = start; i < end; ++i){
+            writeEntry(parsedData[nextEntry()], buffer + offset);
+            offset += recordSize;
         }
-
         seqReader.flushOutput(offset);
     }
 }
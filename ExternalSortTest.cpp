@@ -30,12 +30,13 @@ void generateDummyData(){
     int rowSize = sizeof(int) + sizeof(int) + sizeof(char) + sizeof(pkey_t);
     srand(time(0));
 
-    int numRowsPerPage = PAGE_SIZE / rowSize;
-    int numFullPages = numRows/ numRowsPerPage;
-    int rowsOnLastPage = numRows - numFullPages * numRowsPerPage;
+    row_t numRowsPerPage = PAGE_SIZE / rowSize;
+    row_t numFullPages = numRows/ numRowsPerPage;
+    row_t rowsOnLastPage = numRows - numFullPages * numRowsPerPage;
+    pkey_t pkey = 0;
 
-    for(int pageNo = 0; pageNo < numFullPages; ++pageNo){
-        for(int i = 0; i < numRowsPerPage; ++i){
+    for(row_t pageNo = 0; pageNo < numFullPages; ++pageNo){
+        for(row_t i = 0; i < numRowsPerPage; ++i){
             int x = rand();
             int y = rand();
 
@@ -45,7 +46,8 @@ void generateDummyData(){
             offset += sizeof(int);
             memcpy(buffer + offset, &c, sizeof(char));
             offset += sizeof(char);
-            memcpy(buffer + offset, &i, sizeof(pkey_t));
+            memcpy(buffer + offset, &pkey, sizeof(pkey_t));
+            ++pkey;
             offset += sizeof(pkey_t);
             generatedFile << y << "\n";
         }
@@ -55,7 +57,7 @@ void generateDummyData(){
         offset = 0;
     }
 
-    for(int i = 0; i < rowsOnLastPage; ++i){
+    for(row_t i = 0; i < rowsOnLastPage; ++i){
         int x = rand();
         int y = rand();
 
@@ -65,7 +67,8 @@ void generateDummyData(){
         offset += sizeof(int);
         memcpy(buffer + offset, &c, sizeof(char));
         offset += sizeof(char);
-        memcpy(buffer + offset, &i, sizeof(pkey_t));
+        memcpy(buffer + offset, &pkey, sizeof(pkey_t));
+        ++pkey;
         offset += sizeof(pkey_t);
         generatedFile << y << "\n";
     }
@@ -76,18 +79,20 @@ void generateDummyData(){
 }
 
 int main(){
-    std::string finalName = "extSortTemp/finalOutput.bin";
+    SortOptions options;
+    std::string finalName = options.tempDirectory + "/finalOutput.bin";
     int keySize = sizeof(int32_t);
     int rowOffset = sizeof(int32_t) + sizeof(int32_t) + sizeof(char) + sizeof(pkey_t);
     int columnOffset = sizeof(int32_t);
 //    generateDummyData();
 
-    int rowStack[] = {0};
+    row_t rowStack[] = {0};
     auto t1 = std::chrono::high_resolution_clock::now();
-    ExternalSort<int> sorter("Mydatabase", "table.bin", finalName, numRows, rowStack);
-    sorter.sort(rowOffset, columnOffset, keySize, headerOffset);
+    SortKey key({{DataType::Int, columnOffset, keySize}});
+    ExternalSort sorter("Mydatabase", "table.bin", finalName, numRows, rowStack, options);
+    sorter.sort(rowOffset, key, headerOffset);
     auto t2 = std::chrono::high_resolution_clock::now();
     std::cout << "Time for Sorting: " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count()/1000.0 << std::endl;
-//    convertToText<int>(finalName, "final.txt", keySize, numRows);
+//    convertToText(finalName, "final.txt", key, numRows);
     return 0;
 }
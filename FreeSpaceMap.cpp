@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstring>
+#include "HeaderFiles/FreeSpaceMap.h"
+
+// =============================================
+//                  FREE SPACE MAP
+// =============================================
+
+FreeSpaceMap::FreeSpaceMap(const std::string& fileName): pager(fileName.c_str()){
+    this->numFree = 0;
+    this->firstFreeExtent = 0;
+    int64_t numPages = pager.getFileLength() / PAGE_SIZE;
+    if(numPages == 0){
+        storeCount();
+        return;
+    }
+    // Bitmap pages are flushed apart from count on header page, so count is taken from bitmaps
+    for(int64_t page = 1; page < numPages; ++page){
+        uint64_t* bitmap = words(extent(page - 1));
+        row_t free = 0;
+        for(int32_t i = 0; i < WORDS_PER_EXTENT; ++i) free += __builtin_popcountll(bitmap[i]);
+        extentFree.push_back(free);
+        numFree += free;
+    }
+    row_t storedCount;
+    memcpy(&storedCount, pager.header->buffer.get(), sizeof(row_t));
+    if(storedCount != numFree) storeCount();
+}
+
+Page* FreeSpaceMap::extent(size_t index){
+    Page* page = pager.read(index + 1);
+    if(page == nullptr) throw std::runtime_error("Error reading free space map");
+    return page;
+}
+
+uint64_t* FreeSpaceMap::words(Page* page){
+    return reinterpret_cast<uint64_t*>(page->buffer.get());
+}
+
+void FreeSpaceMap::storeCount(){
+    memcpy(pager.header->buffer.get(), &numFree, sizeof(row_t));
+    pager.header->hasUncommitedChanges = true;
+}
+
+row_t FreeSpaceMap::count() const{
+    return this->numFree;
+}
+
+void FreeSpaceMap::add(row_t location){
+    size_t index = location / EXTENT_SIZE;
+    if(index >= extentFree.size()) extentFree.resize(index + 1, 0);
+    Page* page = extent(index);
+    uint64_t* bitmap = words(page);
+    row_t bit = location % EXTENT_SIZE;
+    uint64_t mask = 1ULL << (bit % 64);
+    if(bitmap[bit / 64] & mask) return;
+    bitmap[bit / 64] |= mask;
+    page->hasUncommitedChanges = true;
+
+    extentFree[index]++;
+    firstFreeExtent = std::min(firstFreeExtent, index);
+    numFree++;
+    storeCount();
+}
+
+row_t FreeSpaceMap::take(){
+    if(numFree == 0) return -1;
+    while(firstFreeExtent < extentFree.size() && extentFree[firstFreeExtent] == 0) ++firstFreeExtent;
+    if(firstFreeExtent == extentFree.size()){
+        numFree = 0;
+        storeCount();
+        return -1;
+    }
+    Page* page = extent(firstFreeExtent);
+    uint64_t* bitmap = words(page);
+    for(int32_t i = 0; i < WORDS_PER_EXTENT; ++i){
+        if(bitmap[i] == 0) continue;
+        int32_t bit = __builtin_ctzll(bitmap[i]);
+        bitmap[i] &= bitmap[i] - 1;
+        page->hasUncommitedChanges = true;
+        extentFree[firstFreeExtent]--;
+        numFree--;
+        storeCount();
+        return (row_t)(firstFreeExtent * EXTENT_SIZE + i * 64 + bit);
+    }
+    throw std::runtime_error("Free space map is inconsistent");
+}
+
+row_t FreeSpaceMap::next(row_t from){
+    for(size_t index = std::max<size_t>(firstFreeExtent, from / EXTENT_SIZE); index < extentFree.size(); ++index){
+        if(extentFree[index] == 0) continue;
+        uint64_t* bitmap = words(extent(index));
+        row_t start = (index == (size_t)(from / EXTENT_SIZE)) ? from % EXTENT_SIZE : 0;
+        for(int32_t i = start / 64; i < WORDS_PER_EXTENT; ++i){
+            uint64_t word = bitmap[i];
+            if(i == start / 64) word &= ~0ULL << (start % 64);
+            if(word == 0) continue;
+            return (row_t)(index * EXTENT_SIZE + i * 64 + __builtin_ctzll(word));
+        }
+    }
+    return -1;
+}
+
+void FreeSpaceMap::remove(row_t location){
+    size_t index = location / EXTENT_SIZE;
+    if(index >= extentFree.size()) return;
+    Page* page = extent(index);
+    uint64_t* bitmap = words(page);
+    row_t bit = location % EXTENT_SIZE;
+    uint64_t mask = 1ULL << (bit % 64);
+    if(!(bitmap[bit / 64] & mask)) return;
+    bitmap[bit / 64] &= ~mask;
+    page->hasUncommitedChanges = true;
+
+    extentFree[index]--;
+    numFree--;
+    storeCount();
+}
+
+std::vector<row_t> FreeSpaceMap::locations(){
+    std::vector<row_t> free;
+    free.reserve(numFree);
+    for(size_t index = firstFreeExtent; index < extentFree.size(); ++index){
+        if(extentFree[index] == 0) continue;
+        uint64_t* bitmap = words(extent(index));
+        for(int32_t i = 0; i < WORDS_PER_EXTENT; ++i){
+            for(uint64_t word = bitmap[i]; word != 0; word &= word - 1){
+                free.push_back((row_t)(index * EXTENT_SIZE + i * 64 + __builtin_ctzll(word)));
+            }
+        }
+    }
+    return free;
+}
+
+bool FreeSpaceMap::flushAll(){
+    return pager.flushAll();
+}
+
+bool FreeSpaceMap::close(){
+    return pager.close();
+}
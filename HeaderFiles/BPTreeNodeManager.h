@@ -7,7 +7,9 @@
 
 #include "BTree.h"
 #include "Constants.h"
+#include "FreeSpaceMap.h"
 #include <unordered_map>
+#include <filesystem>
 #include <list>
 #include <memory>
 
@@ -19,8 +21,8 @@ class BPTreeNodeManager: public Pager<node_t>{
 
 public:
 
-    row_t stackSize;
-    row_t* indexStack;
+    /// Freed node pages, reused by newNode
+    std::unique_ptr<FreeSpaceMap> freePages;
 
     int32_t keySize;
     // int32_t stackPtr;
@@ -34,10 +36,10 @@ public:
     ~BPTreeNodeManager();
     row_t nextFreeIndexLocation();
     void addFreeIndexLocation(row_t location);
-    node_t* read(int32_t pageNo);
+    node_t* read(row_t pageNo);
     node_t* readChild(node_t* parent, int32_t childIndex);
     bool flushPage(node_t* node) override;
-    bool flush(uint32_t pageNum);
+    bool flush(row_t pageNum);
     bool flushAll();
     bool getRoot();
     void setRoot(node_t* newRoot);
@@ -11,6 +11,7 @@
 #include <memory>
 #include <utility>
 #include <functional>
+#include <limits>
 #include "Constants.h"
 #include "Table.h"
 #include "BPTreeNodeManager.h"
@@ -65,8 +66,8 @@ public:
         this->hasUncommitedChanges = true;
     }
 
-    explicit BPTNode(int32_t pageNo):BPTNode(){
-        this->pageNo = pageNo;
+    explicit BPTNode(row_t pageNo):BPTNode(){
+        this->pageNum = pageNo;
     }
 
     ~BPTNode(){}
@@ -83,12 +84,53 @@ struct SearchResult {
     }
 };
 
+/// Bounds of a key range scan. Missing bound means unbounded on that side
+struct KeyRange{
+    bool hasLow = false;
+    bool hasHigh = false;
+    bool lowInclusive = true;
+    bool highInclusive = true;
+    std::string low;
+    std::string high;
+
+    /// Composite keys, values of leading key columns fixed by equality. Bounds are on next key column
+    std::vector<std::string> prefix;
+};
+
+/// Statistics used by optimizer to cost index access paths
+struct IndexStatistics{
+    int32_t height = 0;
+    row_t numPages = 0;
+    row_t leafPages = 0;
+    bool hasBounds = false;         /// true if minKey and maxKey are meaningful
+    bool isNumeric = false;         /// true if keys can be interpolated between minKey and maxKey
+    double minKey = 0;
+    double maxKey = 0;
+    bool clustered = false;         /// true if rows are in leaves, a match costs no heap read
+};
+
 class BPlusTreeBase{
 public:
     int32_t keySize;
     virtual ~BPlusTreeBase() = default;
     virtual void traverseAllWithKey(std::string){}
     virtual bool traverse(const std::function<bool(row_t row)>& callback){return false;}
+    virtual bool rangeScan(const KeyRange& range, const std::function<bool(row_t row)>& callback){return false;}
+    virtual bool rangeScanKeys(const KeyRange& range, const std::function<bool(const std::string& key)>& callback){return false;}
+    virtual bool rangeScanReverse(const KeyRange& range, const std::function<bool(row_t row)>& callback){return false;}
+    virtual IndexStatistics statistics(){return IndexStatistics();}
+    virtual bool firstKey(std::string& key){return false;}
+    virtual bool lastKey(std::string& key){return false;}
+    virtual void setPageCompression(bool enabled){}
+
+    /// Join helpers. Callback gets (row of this index's table, row of other table)
+    virtual bool naturalJoinBothIndex(BPlusTreeBase& other, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback){return false;}
+    virtual bool naturalJoinOneIndex(const std::string& keyOfOther, row_t rowOfOther, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback){return false;}
+
+    /// Index only scans over columns stored with keys. Callback gets a row in fixed width format
+    /// with covered columns filled, other columns are unspecified
+    virtual bool covers(int32_t column){return false;}
+    virtual bool rangeScanCovered(const KeyRange& range, const std::function<bool(char* row)>& callback){return false;}
 };
 
 template <typename key_t>
@@ -110,6 +152,30 @@ public:
     void traverseAllWithKey(const std::string& strKey, const std::function<void(row_t rowOfCurrent)>& funcToPrint);
     void bfsTraverseDebug();
 
+    /// Calls callback with row of every entry in range in key order
+    bool rangeScan(const KeyRange& range, const std::function<bool(row_t row)>& callback) override;
+
+    /// Same as rangeScan but gives key itself, used for index only scans
+    bool rangeScanKeys(const KeyRange& range, const std::function<bool(const std::string& key)>& callback) override;
+
+    /// Same as rangeScan but in descending key order, walks leaves through leftSibling_
+    bool rangeScanReverse(const KeyRange& range, const std::function<bool(row_t row)>& callback) override;
+    IndexStatistics statistics() override;
+
+    /// Smallest and largest key from leftmost and rightmost leaf
+    /// false -> index is empty
+    bool firstKey(std::string& key) override;
+    bool lastKey(std::string& key) override;
+
+    /// Node pages written from now on are compressed on disk, see Pager
+    void setPageCompression(bool enabled) override;
+
+    /// Merge join of leaf chains of this and other index, both on same key type
+    bool naturalJoinBothIndex(BPlusTreeBase& other, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback) override;
+
+    /// Probes this index with key of a row of other table
+    bool naturalJoinOneIndex(const std::string& keyOfOther, row_t rowOfOther, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback) override;
+
     /// true  -> (key, pkey) found and deleted
     /// false -> (key, pkey) not found
     bool remove(const std::string& key, const pkey_t pkey);
@@ -129,8 +195,6 @@ private:
     void splitNode(Node* parent, Node* child, int indexFound);
     void bfsTraverseUtilDebug(Node* start);
     bool traverseUtil(Node* start, const std::function<bool(row_t row)>& callback);
-    void naturalJoinBothIndex(Node* rootOfOtherBTree, const std::function<void(row_t rowOfCurrent, row_t rowOfOther)>& funcToPrint);
-    void naturalJoinOneIndex(Node* rootOfOtherBTree, const std::function<void(row_t rowOfCurrent, row_t rowOfOther)>& funcToPrint);
 
 //    void greaterThanEquals(const key_t& key);
 //    void smallerThanEquals(const key_t& key);
@@ -149,9 +213,14 @@ private:
     std::pair<key_t,pkey_t> getMax(Node* node);
     // Traverse Helpers
     bool iterateRightLeaf(Node* node, int startIndex, const std::function<bool(row_t row)>& callback);
+    template <typename callback_t>
+    bool iterateRange(const KeyRange& range, const callback_t& callback);
+    template <typename callback_t>
+    bool iterateRangeReverse(const KeyRange& range, const callback_t& callback);
 
     // Join Helpers
     BPTNode<key_t>* leftMostLeaf(Node* root);
+    BPTNode<key_t>* rightMostLeaf(Node* root);
 //   void removeMultipleAtLeaf(Node* leaf, int startIndex, int countToDelete);
 //   void iterateLeftLeaf(Node* node, int startIndex);
 };
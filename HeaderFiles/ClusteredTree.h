@@ -0,0 +1,120 @@
+#ifndef DBMS_CLUSTEREDTREE_H
+#define DBMS_CLUSTEREDTREE_H
+
+/// ---------------- CLASS DESCRIPTION ----------------
+/// ClusteredTree is a B+ tree whose leaves hold fixed width records in key order
+/// 1. Clustered table  =>  Records are rows, keyed on the cluster column or pkey if the
+///                         table has none. Tree pages are pages of table file, page p holds
+///                         rows (p - 1) * slotsPerPage + s like fixed width rows, so cursors,
+///                         scans and sorts read its leaves as ordinary data pages
+/// 2. Covering index   =>  Records are some columns of a row with its pkey and row number,
+///                         keyed on (key columns, pkey), see CoveringIndex
+/// A key lookup or range scan reads the path to a leaf and then the records themselves
+///
+/// ------------------ PAGE LAYOUT ------------------
+/// 1. Kind             =>  int32_t   (PageKind)
+/// 2. Count            =>  int32_t   (Leaf => slots in use, Internal => keys)
+/// 3. Next leaf        =>  row_t     (0 if none)
+/// 4. Previous leaf    =>  row_t     (0 if none)
+/// Leaf     => Bitmap of live slots, then slotsPerPage records in key order
+/// Internal => Child 0, then (normalized key, child) entries. Keys of child i are >= key i
+///
+/// Keys are normalized with SortKey so they compare with memcmp, range bounds are
+/// compared with a prefix of the key
+/// A deleted record leaves a hole in its leaf until next insert into that leaf compacts it,
+/// leaves are never merged. With a FreeSpaceMap every slot not holding a live record is in it
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "Pager.h"
+#include "FreeSpaceMap.h"
+#include "SortKey.h"
+#include "BTree.h"
+#include "Constants.h"
+
+/// Records of a ClusteredTree and how they are keyed
+struct RecordFormat{
+    std::vector<SortColumn> keyColumns;     /// Offsets are within record
+    int32_t recordSize = 0;
+    int32_t pkeyOffset = -1;                /// pkey in record, appended to key so equal keys can repeat. -1 => key is unique
+    int32_t rowOffset = -1;                 /// Row number in record. -1 => record is a row of table at its slot
+};
+
+class ClusteredTree: public BPlusTreeBase{
+    enum class PageKind: int32_t{
+        unused,
+        leaf,
+        internal
+    };
+
+    static constexpr int32_t HEADER_SIZE = 2 * sizeof(int32_t) + 2 * sizeof(row_t);
+
+    Pager<Page>* pager;
+    FreeSpaceMap* freeMap;                  // nullptr if slots aren't tracked
+    RecordFormat format;
+    SortKey key;
+    int32_t slots;
+    int32_t dataOffset;
+    int32_t keyWidth;
+    int32_t fanOut;                         // Keys of an internal page
+    row_t root;
+    row_t numPages;
+
+    Page* page(row_t pageNum);
+    row_t allocate(PageKind kind);
+    char* recordAt(Page* page, int32_t slot) const;
+    bool isLive(Page* page, int32_t slot) const;
+    void setLive(Page* page, int32_t slot, bool live);
+    row_t rowOf(row_t pageNum, int32_t slot, const char* record) const;
+    void encodeKey(const char* record, char* out) const;
+    int32_t encodeBound(size_t column, const std::string& value, char* out) const;
+
+    row_t findLeaf(const char* searchKey, int32_t width, bool upper, std::vector<std::pair<row_t, int32_t>>* path = nullptr);
+    row_t edgeLeaf(bool rightmost);
+    int32_t lowerBound(Page* leaf, const char* searchKey, int32_t width, bool upper);
+    void compact(Page* leaf);
+    void insertAt(Page* leaf, int32_t slot, const char* record);
+    void insertIntoParent(std::vector<std::pair<row_t, int32_t>>& path, std::vector<char> separator, row_t child);
+    bool edgeKey(bool last, std::string& value);
+
+public:
+    /// numPages_ are pages of file after its header page
+    ClusteredTree(Pager<Page>* pager_, FreeSpaceMap* freeMap_, RecordFormat format_, row_t root_, row_t numPages_);
+
+    /// Slots of a leaf and offset of its first record for records of recordSize bytes
+    static int32_t slotsPerPage(int32_t pageSize, int32_t recordSize);
+    static int32_t recordsOffset(int32_t pageSize, int32_t recordSize);
+
+    /// Root page, 0 while tree is empty. Changes when root splits
+    row_t getRoot() const;
+    row_t getNumPages() const;
+
+    /// Inserts record in key order and returns number of its slot in file
+    /// -1 if a live record has the same key
+    row_t insert(const char* record);
+
+    /// Leaves a hole where row was, slot is given back to FreeSpaceMap by Table::freeSlot
+    void erase(row_t row);
+
+    /// Leaves a hole where record with same key was, false if there is none
+    bool remove(const char* record);
+
+    /// Calls callback with row number and record of every live record in range, in key order or reversed
+    bool scan(const KeyRange& range, bool reverse, const std::function<bool(row_t row, const char* record)>& callback);
+
+    bool traverse(const std::function<bool(row_t row)>& callback) override;
+    bool rangeScan(const KeyRange& range, const std::function<bool(row_t row)>& callback) override;
+    bool rangeScanKeys(const KeyRange& range, const std::function<bool(const std::string& key)>& callback) override;
+    bool rangeScanReverse(const KeyRange& range, const std::function<bool(row_t row)>& callback) override;
+    IndexStatistics statistics() override;
+    bool firstKey(std::string& value) override;
+    bool lastKey(std::string& value) override;
+    bool naturalJoinOneIndex(const std::string& keyOfOther, row_t rowOfOther, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback) override;
+
+    /// Records of a clustered table are its rows, so they cover every column
+    bool covers(int32_t column) override;
+    bool rangeScanCovered(const KeyRange& range, const std::function<bool(char* row)>& callback) override;
+};
+
+#endif //DBMS_CLUSTEREDTREE_H
@@ -0,0 +1,85 @@
+#ifndef DBMS_COMPRESSEDPAGE_H
+#define DBMS_COMPRESSEDPAGE_H
+
+/// ---------------- CLASS DESCRIPTION ----------------
+/// CompressedPage reads and writes data pages of a table with compressed layout
+/// Like pax, values of a column are stored together, but each column of a page is
+/// encoded with whichever of these is smallest for its values on that page
+/// 1. plain            =>  Fixed width values back to back
+/// 2. dictionary       =>  string, distinct values once and a one byte code per slot
+/// 3. runLength        =>  bool/char, runs of equal values
+/// 4. frameOfReference =>  int, minimum of page and every value as offset from it bit packed
+///
+/// ------------------ PAGE LAYOUT ------------------
+/// 1. Field headers        =>  (columns + pkey) x (int32_t encoding, int32_t offset of data in page)
+/// 2. Encoded fields       =>  Back to back, see encode functions in CompressedPage.cpp
+///
+/// All fields are zero on a page that was never written, space after last field is zeroed
+/// so that page compression of Pager leaves it out
+/// Slot s of page holds row (page - 1) * slotsPerPage + s like fixed width rows. A page
+/// is encoded again from its image whenever a row of it changes, see Table::storeRow
+
+#include <vector>
+#include <functional>
+#include "DataTypes.h"
+#include "Constants.h"
+
+enum class ColumnEncoding: int32_t{
+    plain,
+    dictionary,
+    runLength,
+    frameOfReference
+};
+
+/// Predicate on values of one column, see CompressedPage::match
+struct ColumnPredicate{
+    /// Evaluates one value in fixed width format
+    std::function<bool(const char*)> test;
+
+    /// Int predicates are also given as value in [low, high], negated for !=
+    /// so they are evaluated on frame of reference offsets without decoding them
+    bool isRange = false;
+    int64_t low = 0;
+    int64_t high = 0;
+    bool negate = false;
+};
+
+class CompressedPage{
+    static constexpr int32_t FIELD_HEADER_SIZE = 2 * sizeof(int32_t);
+    static constexpr int32_t MAX_DICTIONARY_SIZE = 256;
+
+    std::vector<DataType> fieldTypes;       // Columns then pkey
+    std::vector<uint32_t> fieldSizes;
+    std::vector<uint32_t> fieldOffsets;     // Offset of field in fixed width row
+    int32_t pageSize;
+    int32_t rowSize;
+    int32_t headerSize;
+    int32_t numSlots;
+
+    int32_t encodeField(const char* rows, int32_t field, char* out, ColumnEncoding& encoding) const;
+    void decodeField(const char* page, int32_t field, int32_t from, int32_t count, char* rows) const;
+    const char* fieldData(const char* page, int32_t field) const;
+
+public:
+    CompressedPage(const std::vector<DataType>& columnTypes, const std::vector<uint32_t>& columnSizes, int32_t pageSize_);
+
+    int32_t slotsPerPage() const;
+
+    /// Encodes slotsPerPage fixed width rows into page
+    void compress(const char* rows, char* page) const;
+
+    /// Decodes page into slotsPerPage fixed width rows
+    void expand(const char* page, char* rows) const;
+
+    void read(const char* page, int32_t slot, char* row) const;
+
+    ColumnEncoding encoding(const char* page, int32_t field) const;
+
+    /// Sets matches[i] to whether value of field in slot from + i satisfies predicate
+    /// Predicate is evaluated once per dictionary entry or run, ints are compared as
+    /// offsets from minimum of page
+    void match(const char* page, int32_t field, int32_t from, int32_t count,
+               const ColumnPredicate& predicate, uint8_t* matches) const;
+};
+
+#endif //DBMS_COMPRESSEDPAGE_H
@@ -10,8 +10,16 @@
 #define MAX_COLUMN_SIZE 50
 const int32_t PAGE_SIZE = 4096;
 const int DEFAULT_PAGE_LIMIT = 20;
-using row_t = int32_t;
-using pkey_t = int32_t;
+const int32_t BATCH_SIZE = 1024;               // Rows processed together by batch executor
+const int64_t JOIN_MEMORY_LIMIT = (1 << 26);    // 64MB for in memory side of a join
+const int32_t JOIN_MAX_PARTITIONS = 256;        // Partitions (open spill files per side) of grace hash join
+const int64_t AGGREGATE_MEMORY_LIMIT = (1 << 26);   // 64MB for groups of hash aggregation
+const int32_t AGGREGATE_PARTITIONS = 16;        // Spill files of hash aggregation per level
+const int64_t SORT_MEMORY_LIMIT = (1 << 26);    // 64MB of rows sorted in memory by order by
+const int64_t SPILL_MEMORY_LIMIT = (1 << 26);   // 64MB of spill buffers of a join or aggregation
+const int64_t SPILL_BLOCK_SIZE = (1 << 24);     // 16MB largest spill buffer
+using row_t = int64_t;              // Row ids and page numbers, see FORMAT_VERSION in Pager.h
+using pkey_t = int64_t;
 #define printw printf
 
 const int32_t BPTNodeSizeOffset         = sizeof(bool);
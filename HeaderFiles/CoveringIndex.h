@@ -0,0 +1,79 @@
+#ifndef DBMS_COVERINGINDEX_H
+#define DBMS_COVERINGINDEX_H
+
+/// ---------------- CLASS DESCRIPTION ----------------
+/// CoveringIndex is a composite index on one or more key columns that can also store
+/// values of included columns. Its leaves hold one record per row of table, so a select
+/// reading only these columns is answered from the index without reading table pages
+/// Records are kept in a ClusteredTree of its own file, keyed on (key columns, pkey)
+/// Key columns are normalized and concatenated, so equality on leading key columns and
+/// a range on next one is a single range of leaves, see KeyRange::prefix
+///
+/// ------------------ RECORD LAYOUT ------------------
+/// 1. Covered values   =>  Key columns, then included columns, fixed width format of table
+/// 2. pkey             =>  pkey_t
+/// 3. Row              =>  row_t    (row of table the record belongs to)
+///
+/// ------------------ HEADER PAGE ------------------
+/// 1. Root             =>  row_t
+/// 2. Number of pages  =>  row_t    (pages after header)
+/// 3. Key columns      =>  int32_t count, then int32_t column numbers
+/// 4. Included columns =>  int32_t count, then int32_t column numbers
+///
+/// Table keeps records in step with its rows on insert, update and delete
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Pager.h"
+#include "ClusteredTree.h"
+#include "DataTypes.h"
+#include "Constants.h"
+
+class CoveringIndex: public BPlusTreeBase{
+    Pager<Page> pager;
+    std::vector<int32_t> keyColumns;
+    std::vector<int32_t> includedColumns;
+    std::vector<int32_t> coveredColumns;        // Key columns then included columns
+    std::vector<uint32_t> columnSizes;          // Of every column of table
+    std::vector<uint32_t> columnOffsets;        // In table row
+    std::vector<int32_t> recordOffsets;         // Of each covered column in record
+    int32_t rowSize;
+    int32_t recordSize;
+    std::unique_ptr<ClusteredTree> tree;
+
+    void storeHeader();
+    void makeRecord(const char* row, row_t location, char* record) const;
+
+public:
+    /// Columns are used only when file is new, otherwise they are read from its header
+    CoveringIndex(const std::string& fileName, std::vector<int32_t> keyColumns_, std::vector<int32_t> includedColumns_,
+                  const std::vector<DataType>& columnTypes, const std::vector<uint32_t>& columnSizes_);
+
+    const std::vector<int32_t>& getKeyColumns() const;
+    const std::vector<int32_t>& getIncludedColumns() const;
+
+    /// Adds record of row stored at location, false if its (key, pkey) is already present
+    bool insert(const char* row, row_t location);
+    bool remove(const char* row);
+
+    /// Replaces record of oldRow with that of newRow, nothing is done if covered values and location are same
+    bool update(const char* oldRow, row_t oldLocation, const char* newRow, row_t newLocation);
+
+    bool flushAll();
+    bool close();
+
+    bool traverse(const std::function<bool(row_t row)>& callback) override;
+    bool rangeScan(const KeyRange& range, const std::function<bool(row_t row)>& callback) override;
+    bool rangeScanKeys(const KeyRange& range, const std::function<bool(const std::string& key)>& callback) override;
+    bool rangeScanReverse(const KeyRange& range, const std::function<bool(row_t row)>& callback) override;
+    IndexStatistics statistics() override;
+    bool firstKey(std::string& key) override;
+    bool lastKey(std::string& key) override;
+    void setPageCompression(bool enabled) override;
+    bool naturalJoinOneIndex(const std::string& keyOfOther, row_t rowOfOther, const std::function<bool(row_t rowOfCurrent, row_t rowOfOther)>& callback) override;
+    bool covers(int32_t column) override;
+    bool rangeScanCovered(const KeyRange& range, const std::function<bool(char* row)>& callback) override;
+};
+
+#endif //DBMS_COVERINGINDEX_H
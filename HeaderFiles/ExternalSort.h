@@ -10,6 +10,8 @@
 #include <condition_variable>
 #include <future>
 #include <queue>
+#include <functional>
+#include <cmath>
 #include <filesystem>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -17,43 +19,69 @@
 #include <sys/file.h>
 #include "DataTypes.h"
 #include "Constants.h"
+#include "SortKey.h"
+
+#define MIN_SORT_MEMORY                 (1 << 20)                          // Smaller memory budgets are raised to this
+#define MIN_MERGE_READ_SIZE             (1 << 18)                          // Smallest input buffer of a merge, bounds fan-in
+#define MIN_ROWS_PER_SORTING_THREAD     (1 << 16)                          // Smaller runs use fewer threads
+
+/// Runtime configuration of an ExternalSort
+/// All buffer sizes are derived from memoryBudget
+/// 1. Run generation => table reads 1/2, run writes 1/4, sorting buffer 1/4 (reads and writes double buffered)
+/// 2. Merge          => merged output 1/4 (double buffered), input buffers of all merged runs 3/4
+struct SortOptions{
+    int64_t memoryBudget = (1 << 27);               /// Bytes of all buffers of one sort, 128MB
+    std::string tempDirectory = "extSortTemp";      /// Runs are written here, created if missing
+    int fanIn = 0;                                  /// Runs merged at once, 0 => from memoryBudget and run count
+    int threads = 0;                                /// Threads sorting a run, 0 => one per core
+    bool asyncIO = true;                            /// Reads and writes overlap sorting on IOWorker threads
+    bool replacementSelection = false;              /// Initial runs by replacement selection instead of sorting the buffer
+};
 
-//#define SEQ_READ_ASYNC
-//#define SEQ_WRITE_ASYNC
-//#define EXT_READ_ASYNC
-//#define EXT_WRITE_ASYNC
-
-#define MAX_MEMORY_USAGE                (1 << 27)                          // 64MB
-#define EXTERNAL_SORTING_K              6                                  // Constant K for K-way merge
-
+using block_t = int64_t;
 
-#define SEQ_READ_BLOCKS                 2                                  // Num of Blocks in seq read block
-#define SEQ_WRITE_BLOCKS                1                                  // Num of Blocks in seq write block
-#define SORTING_BUFFER_BLOCKS           2                                  // Num of Blocks in sorting buffers
+/// Persistent thread running I/O tasks in the order they are submitted
+/// Async readers and writers hand it the fill or flush of their secondary buffer, so at most
+/// one block per buffer pair is in flight and prefetch is bounded by the memory of those buffers
+class IOWorker{
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::queue<std::packaged_task<void()>> tasks;
+    bool stopping = false;
 
-static const uint64_t seqBlockSize      = (MAX_MEMORY_USAGE / 8);
-static const uint64_t seqReadBlockSize  = SEQ_READ_BLOCKS * seqBlockSize;
-static const uint64_t seqWriteBlockSize = SEQ_WRITE_BLOCKS * seqBlockSize;
+    void run();
 
-#define EXT_READ_BLOCKS                 1                                  // Num of Blocks in seq read block
-#define EXT_WRITE_BLOCKS                2                                  // Num of Blocks in seq write block
+public:
+    IOWorker();
+    ~IOWorker();
 
-static const uint32_t extBlockSize      = (MAX_MEMORY_USAGE / 16);
+    /// Future gets exception thrown by task, if any
+    std::future<void> submit(std::function<void()> task);
+};
 
-using block_t = int64_t;
+/// Waits for a submitted task, rethrows its exception
+inline void waitFor(std::future<void>& done){
+    if(done.valid()) done.get();
+}
 
 /// This is responsible for sequentially reading table file
 /// This is double buffered
+/// With setAsync(true) next block is read and last block written by persistent IOWorkers
 class SeqPageReader{
-    int inFileDescriptor;
-    int outFileDescriptor;
+    int inFileDescriptor = -1;
+    int outFileDescriptor = -1;
     int64_t inputFileSize;
     int64_t outputFileSize;
-    int requiredNumberOfFetches;
-    int currentFetchNumber;
-
-    std::thread readThread;
-    std::thread writeThread;
+    int64_t readBlockSize;
+    int64_t requiredNumberOfFetches;
+    int64_t currentFetchNumber;
+
+    bool async = false;
+    std::unique_ptr<IOWorker> readWorker;
+    std::unique_ptr<IOWorker> writeWorker;
+    std::future<void> readDone;
+    std::future<void> writeDone;
     bool finishedFetching = false;
 
     std::unique_ptr<char[]> secondaryInputBuffer;
@@ -68,10 +96,16 @@ public:
 
     SeqPageReader() = default;
     ~SeqPageReader();
-    void initialise(const char* inFileName, const char* outFileName, uint32_t headerOffset);
+
+    /// Takes effect from next initialise
+    void setAsync(bool enable);
+
+    /// readBlockSize_ should be a multiple of page size of input file
+    void initialise(const char* inFileName, const char* outFileName, uint32_t headerOffset,
+                    int64_t readBlockSize_, int64_t writeBlockSize);
 
     void fetchInput();
-    void flushOutput(int64_t outputBuffSize = seqWriteBlockSize);
+    void flushOutput(int64_t outputBuffSize);
     void flushOutputToStorage(int64_t outputBuffSize);
     void flushRemaining();
 
@@ -83,37 +117,110 @@ private:
 };
 
 
-template <typename key_t>
-struct KRPair{
-    row_t row;
-    key_t key;
+/// This is responsible for appending rows to a spill file e.g. a partition of hash join
+/// Output is double buffered like SeqPageReader
+class SpillWriter{
+    int outFileDescriptor = -1;
+    int64_t blockSize = 0;
+    int64_t bufferSize = 0;                 /// Bytes filled in primary buffer
+    int64_t bytesWritten = 0;
+
+    bool async = false;
+    std::unique_ptr<IOWorker> writeWorker;
+    std::future<void> writeDone;
+    std::unique_ptr<char[]> primaryOutputBuffer;
+    std::unique_ptr<char[]> secondaryOutputBuffer;
+
+public:
+    SpillWriter() = default;
+    ~SpillWriter();
 
-    KRPair() = default;
-    KRPair(key_t&& key_, row_t row_): key(std::move(key_)), row(row_) {}
+    /// Takes effect from next initialise
+    void setAsync(bool enable);
 
-    bool operator<(const KRPair<key_t>& kr2) const {
-        return key < kr2.key;
-    }
+    /// File is truncated. blockSize should be a multiple of size of appended records
+    bool initialise(const char* outFileName, int64_t blockSize_);
+    void append(const char* data, int64_t size);
+    void flushRemaining();
+    int64_t size() const;
 
-    bool operator>(const KRPair<key_t>& kr2) const {
-        return key > kr2.key;
-    }
+private:
+    void flushOutput();
+    void flushOutputToStorage(int64_t outputBuffSize);
+    void flushOutputToSecondary();
 };
 
-template <>
-struct KRPair<char[]>{
-    row_t row;
-    char key[];
-    bool operator<(const KRPair<char[]>& kr2){
-        return (strcmp(key, kr2.key) < 0);
-    }
-
-    bool operator>(const KRPair<char[]>& kr2){
-        return (strcmp(key, kr2.key) > 0);
-    }
+/// This is responsible for sequentially reading a spill file written by SpillWriter
+/// Input is double buffered like SeqPageReader
+class SpillReader{
+    int inFileDescriptor = -1;
+    int64_t blockSize = 0;
+    int64_t secondarySize = 0;              /// Bytes prefetched in secondary buffer
+
+    bool async = false;
+    std::unique_ptr<IOWorker> readWorker;
+    std::future<void> readDone;
+    std::unique_ptr<char[]> secondaryInputBuffer;
+
+public:
+    std::unique_ptr<char[]> primaryInputBuffer;
+    int64_t bufferSize = 0;
+
+    SpillReader() = default;
+    ~SpillReader();
+
+    /// Takes effect from next initialise
+    void setAsync(bool enable);
+    bool initialise(const char* inFileName, int64_t blockSize_);
+
+    /// Moves next block into primary buffer
+    /// Returns bytes in primary buffer, 0 at end of file
+    int64_t fetchInput();
+    void flushRemaining();
+
+private:
+    void fetchFromSecondary();
+    void fetchFromStorage();
 };
 
 
+/// Writes decoded (key, row) records of a sorted file as text, used for debugging
+void convertToText(const std::string& infileName, const std::string& outFileName, const SortKey& key, row_t rowCount);
+
+/// Sorted run of (key, row) records in a partially sorted file
+struct SortRun{
+    uint64_t offset;                        /// Byte offset of first record
+    uint64_t bytes;
+};
+
+/// Tournament tree merging k sorted sources of records on memcmp of their keys
+/// Every internal node keeps loser of the match played there and node 0 keeps overall winner,
+/// so replacing winner replays only its path to root, log k comparisons per record
+/// Ties go to lower source so merging consecutive runs is stable
+class LoserTree{
+    std::vector<int> losers;
+    std::vector<const char*> heads;         /// Current record of every source, nullptr once exhausted
+    int32_t keyWidth;
+    int k;
+
+    bool before(int a, int b) const;
+    int build(int node);
+
+public:
+    LoserTree(int k_, int32_t keyWidth_);
+
+    void set(int source, const char* head);
+
+    /// Plays all matches once heads of all sources are set
+    void build();
+    bool empty() const;
+    int winner() const;
+    const char* top() const;
+
+    /// Replaces record of winner by its next record (nullptr if its source is exhausted)
+    void replace(const char* head);
+};
+
 /// This is responsible for
 /// 1. maintaining Input (double Buffered) and Output Buffers
 /// 2. Filling primary and secondary buffers
@@ -121,112 +228,177 @@ struct KRPair<char[]>{
 class ExtSortPager{
     int inFileDescriptor;
     int outFileDescriptor;
-    int64_t blocksPerBuffer;
-    int64_t fileSize;
+    std::vector<SortRun> runs;              /// Input runs being merged, one per input buffer
     int64_t offset;
 
-    std::thread readThread;
-    std::thread writeThread;
-
-    std::mutex inputMutex[EXTERNAL_SORTING_K];
-    std::mutex queueMutex;
-
-    std::condition_variable condition;
-    std::queue<std::pair<std::promise<bool>, int>> fillRequests;
+    bool async = false;
+    std::unique_ptr<IOWorker> readWorker;   /// Fills secondary input buffers of all runs
+    std::unique_ptr<IOWorker> writeWorker;
+    std::vector<std::future<void>> futures;
+    std::future<void> writeDone;
 
-    std::unique_ptr<char[]> secondaryInputBuffer[EXTERNAL_SORTING_K];
+    std::vector<std::unique_ptr<char[]>> secondaryInputBuffer;
     std::unique_ptr<char[]> secondaryOutputBuffer;
-    std::future<bool> futures[EXTERNAL_SORTING_K];
 
-    int timesFetched[EXTERNAL_SORTING_K] = {0};
-    bool finishedFetchingAll = false;
+    std::vector<int> timesFetched;
     int k;
 
 public:
-    std::unique_ptr<char[]> primaryInputBuffer[EXTERNAL_SORTING_K];
+    std::vector<std::unique_ptr<char[]>> primaryInputBuffer;
     std::unique_ptr<char[]> primaryOutputBuffer;
     size_t readSize;
 
     ExtSortPager();
     ~ExtSortPager();
-    void initialise(const char* inFileName, const char* outFileName, int64_t blocksPerBuffer_, uint64_t offset_, int k_);
+
+    /// Takes effect from next initialise, workers are kept across merges
+    void setAsync(bool enable);
+
+    /// Output is written at offset of first run, merged run replaces the input runs
+    void initialise(const char* inFileName, const char* outFileName, std::vector<SortRun> runs_, size_t readSize_, int64_t writeBlockSize);
     void fetchInput(int bufferNo, bool fetchMore);
     void flushOutput(off_t outputBuffSize);
     void flushOutputToStorage(uint64_t outputBuffSize);
     void flushRemaining();
-    void endFetching();
 
 private:
     static bool open(const char* fileName, int& fd, int mode);
-    void storageFetcher();
     void fetchFromSecondary(int bufferNo);
     void fetchFromStorage(int bufferNo);
     void flushOutputToSecondary();
 };
 
-template<typename key_t>
+/// Sorts live rows of a table file on a SortKey
+/// Output file has a (normalized key, row) record for every row in key order
 class ExternalSort{
-    using data_t      = KRPair<key_t>;
-    using heap_data_t = std::pair<KRPair<key_t>, int>;
-    using heap_t      = std::priority_queue <heap_data_t, std::vector<heap_data_t>, std::greater<>>;
-
     std::string fileName;                   /// File name of table to sort
 
 public:
-    ExternalSort(const std::string& fileName_,
-                 const std::string& databaseName_,
+    /// numRows_ is number of slots in table including deleted rows listed in rowStack
+    ExternalSort(const std::string& databaseName_,
+                 const std::string& fileName_,
+                 const std::string& finalSortedFileName_,
+                 row_t numRows_, row_t* rowStack,
+                 const SortOptions& options_ = SortOptions());
+
+    /// tableFileName is path of table file, deletedRows_ are its deleted slots
+    ExternalSort(const std::string& tableFileName,
                  const std::string& finalSortedFileName_,
-                 row_t numRows_, int* rowStack);
+                 row_t numRows_, std::vector<row_t> deletedRows_,
+                 const SortOptions& options_ = SortOptions());
 
     /// Wrapper which calls other functions
-    void sort(int rowSize_, int columnOffset_, int32_t keySize, uint32_t headerOffset);
+    void sort(int rowSize_, const SortKey& key_, uint32_t headerOffset);
+
+    /// Bytes of one record of sorted file
+    int32_t getRecordSize() const;
+
+    /// Expands a page of table file into rowsPerPage fixed width rows
+    /// Set for tables whose pages don't hold fixed width rows e.g. slotted pages
+    using PageDecoder = std::function<void(const char* page, char* rows)>;
+    void setPageDecoder(int32_t rowsPerPage, PageDecoder decoder);
+
+    /// Page size of table file, PAGE_SIZE unless table was created with another, see Pager
+    void setPageSize(int32_t pageSize_);
 
 private:
-    std::string tempFileName;                  /// FileName of file containing extracted rows
     std::string partiallySortedFileName[2];    /// Alternate b/w these two file names
     std::string finalSortedFileName;
 
     ExtSortPager pager;                        /// Handles disk I/O for partially sorted File
-    std::vector<int> deletedRows;              /// Contains rows numbers of deleted rows
+    std::vector<row_t> deletedRows;            /// Contains rows numbers of deleted rows
     row_t numRows;
-    int64_t fileSize;
-    int keySize;
+    SortKey key;
+    int32_t recordSize;
+
+    /// With options.replacementSelection initial runs are generated by selectRuns
+    /// Runs average twice the buffer on random input and nearly sorted input gives a single run
+    SortOptions options;
+
+    /// Buffer sizes derived from options.memoryBudget
+    int64_t readBlockSize;                     /// Table reads, a multiple of pageSize
+    int64_t writeBlockSize;                    /// Run writes and merged output
+    int64_t sortBufferSize;
+    int64_t mergeInputMemory;                  /// Input buffers of all runs of one merge
+    int64_t maxMergeReadSize;
 
     /// Reads the main table and copy all valid entries to another file
     /// only (key, rowNo) is copied not the entire row
     void getData(uint32_t headerOffset);
 
+    /// Heap entry of replacement selection, record is in slot of sortBuffer
+    /// Records that can't extend current run wait in heap for next run
+    struct SelectionEntry{
+        uint64_t prefix;
+        uint32_t run;
+        row_t slot;
+    };
+
+    /// Writes runs of all rows using a heap of records the size of sorting buffer
+    void selectRuns();
+
     SeqPageReader seqReader;
     char* inputBuffer;
+    PageDecoder pageDecoder;
+    int32_t decodedRowsPerPage = 0;
+    int32_t pageSize = PAGE_SIZE;
+    std::unique_ptr<char[]> decodedPage;       /// Rows of current page when pageDecoder is set
 
     row_t currentReadBufferNumber;
     row_t currentReadPageNumber;
     row_t currentReadRowInPage;
     row_t currentReadRow;
+    bool pendingFetch;
     row_t rowsInSinglePage;
     row_t currentWriteRowInSortingBuffer;
     row_t currentWriteRow;
     row_t rowsInSingleBlock;
     row_t numPagesInInputBuffer;
     int64_t readOffset;
-    int columnOffset;
     int rowSize;
 
-    std::vector<data_t> parsedData;
+    /// Runs are sorted on first 8 bytes of key packed in an integer
+    /// If key is longer, index points to full record in sortBuffer, otherwise it is the row itself
+    struct SortEntry{
+        uint64_t prefix;
+        row_t index;
+    };
+    std::vector<SortEntry> parsedData;
+    std::vector<SortEntry> radixBuffer;        /// Scratch space of radix sort, same size as parsedData
+    std::unique_ptr<char[]> sortBuffer;
 
     void initReader();
-    bool readNextRow(key_t& key);
+    bool readNextRow(const char*& row);
+    size_t nextDeletedRow;
+
+    /// Skips deleted rows, rowNo is row number of returned row
+    bool readNextLiveRow(const char*& row, row_t& rowNo);
+    uint64_t prefixOf(const char* record) const;
     void initWriter();
-    void writeNextRow(key_t& key, row_t row);
+    void writeNextRow(const char* row, row_t rowNo);
+    int sortingThreads;
+
+    /// Sorts rows of sorting buffer in parallel chunks, merges chunks and writes them as a run
     void sortBufferAndWrite(row_t rows);
+    bool entryBefore(const SortEntry& a, const SortEntry& b) const;
 
-    /// Reads the given input file and and performs k way merge
-    /// Write the output to output file
-    row_t rowsPerInputBlock;
+    /// LSD radix sort of entries on significant bytes of prefix, used when whole key is in prefix
+    /// Passes where every entry has the same byte are skipped
+    void radixSort(SortEntry* begin, SortEntry* end, SortEntry* temp) const;
+    void writeEntry(const SortEntry& entry, char* buffer);
+
+    /// Runs written by getData, replaced by merged runs after every merge pass
+    std::vector<SortRun> runs;
     row_t rowsPerOutputBlock;
     int fileIdx = 0;
 
-    void kWayMerge(row_t sortedRows, int64_t mergeIdx);
+    /// Number of runs merged at once, options.fanIn if set. Otherwise all runs are merged
+    /// in one pass unless that makes their buffers in mergeInputMemory smaller than MIN_MERGE_READ_SIZE
+    int mergeFanIn() const;
+
+    /// Reads runs [first, first + count) of input file and merges them with a LoserTree
+    /// Merged run is written at same offset of output file
+    SortRun kWayMerge(size_t first, size_t count, int fanIn);
 };
 
 #include "../ExternalSort.cpp"
@@ -0,0 +1,54 @@
+#ifndef DBMS_FREESPACEMAP_H
+#define DBMS_FREESPACEMAP_H
+
+/// ---------------- CLASS DESCRIPTION ----------------
+/// FreeSpaceMap tracks free row slots of a table or free node pages of an index
+/// It lives in its own file so it grows with number of deletes
+/// 1. Page 0  => Number of free locations, recounted from bitmaps when opened
+/// 2. Page e  => Bitmap of extent e - 1 i.e. locations [(e - 1) * EXTENT_SIZE, e * EXTENT_SIZE)
+///               Bit is set if location is free
+///
+/// Free count of every extent is kept in memory. take() goes to lowest extent with a
+/// free location and returns lowest free location in it, so partially free pages at
+/// front of the file are filled before the file grows
+
+#include <string>
+#include <vector>
+#include "Pager.h"
+#include "Constants.h"
+
+class FreeSpaceMap{
+    static constexpr row_t EXTENT_SIZE = PAGE_SIZE * 8;
+    static constexpr int32_t WORDS_PER_EXTENT = PAGE_SIZE / sizeof(uint64_t);
+
+    Pager<Page> pager;
+    row_t numFree;
+    std::vector<row_t> extentFree;              // Free locations in each extent
+    size_t firstFreeExtent;                     // No extent before this has a free location
+
+    Page* extent(size_t index);
+    static uint64_t* words(Page* page);
+    void storeCount();
+
+public:
+    explicit FreeSpaceMap(const std::string& fileName);
+
+    row_t count() const;
+    void add(row_t location);
+
+    /// Removes and returns lowest free location, -1 if there is none
+    row_t take();
+
+    /// Lowest free location not below from, -1 if there is none. Location stays free
+    row_t next(row_t from);
+
+    void remove(row_t location);
+
+    /// Free locations in ascending order
+    std::vector<row_t> locations();
+
+    bool flushAll();
+    bool close();
+};
+
+#endif //DBMS_FREESPACEMAP_H
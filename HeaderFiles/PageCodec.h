@@ -0,0 +1,32 @@
+#ifndef DBMS_PAGECODEC_H
+#define DBMS_PAGECODEC_H
+
+/// ---------------- CLASS DESCRIPTION ----------------
+/// PageCodec is a small LZ77 codec used by Pager to compress pages on disk
+/// A compressed page is a list of sequences
+/// 1. Token            =>  uint8_t  (literal count << 4 | (match length - MIN_MATCH))
+/// 2. Literal count    =>  more uint8_t if count in token is 15, added until one is below 255
+/// 3. Literals
+/// 4. Match offset     =>  uint16_t  (distance back from current output position)
+/// 5. Match length     =>  more uint8_t if length in token is 15, like literal count
+///
+/// Last sequence has only literals. Matches are found through a hash of 4 byte prefixes,
+/// so runs of zeros and repeated values in a page shrink to a few bytes
+
+#include <cinttypes>
+
+class PageCodec{
+    static constexpr int32_t MIN_MATCH = 4;
+    static constexpr int32_t MAX_OFFSET = 65535;
+    static constexpr int32_t HASH_BITS = 12;
+
+public:
+    /// Compresses size bytes of in into out, returns compressed length
+    /// Returns 0 if it wouldn't fit in limit bytes
+    static int32_t compress(const char* in, int32_t size, char* out, int32_t limit);
+
+    /// Decompresses length bytes of in into out, false unless it gives exactly size bytes
+    static bool decompress(const char* in, int32_t length, char* out, int32_t size);
+};
+
+#endif //DBMS_PAGECODEC_H
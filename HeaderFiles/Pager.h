@@ -5,6 +5,27 @@
 /// Pager directly deals with File IO
 /// It can read/write given page in a file
 /// It also maintains a cache of recently used pages
+///
+/// ------------------ FILE FOOTER ------------------
+/// Last PAGER_FOOTER_SIZE bytes of page 0 of every file belong to Pager
+/// 1. Magic            =>  uint32_t  (FILE_MAGIC)
+/// 2. Flags            =>  uint32_t  (PAGE_COMPRESSION)
+/// 3. Page size        =>  int32_t   (Chosen when file is created)
+/// 4. Format version   =>  uint32_t  (FORMAT_VERSION)
+///
+/// Footer is always at end of first PAGE_SIZE bytes so it is found before page size is known
+/// Files of another format version, or without footer i.e. with 32 bit row ids, aren't opened
+///
+/// ------------------ PAGE COMPRESSION ------------------
+/// With PAGE_COMPRESSION every page takes a frame of page size + FRAME_HEADER_SIZE bytes
+/// in the file, see getFrameSize. Pages other than page 0 are written as a frame
+/// 1. Magic            =>  uint32_t  (FRAME_MAGIC)
+/// 2. Kind             =>  uint32_t  (FRAME_RAW or FRAME_COMPRESSED)
+/// 3. Length           =>  int32_t   (Bytes of data)
+/// 4. Data             =>  PageCodec output, or page as it is if it doesn't compress
+/// Rest of frame is punched out of the file so it takes no space and reads as zeros
+/// A frame of zeros is a page never written. Any other frame which doesn't decode fails
+/// the read. Compression is chosen before file has pages. Cached pages are always decompressed
 
 #include <cstdio>
 #include <cstdlib>
@@ -18,16 +39,31 @@
 #include <functional>
 #include <queue>
 #include <list>
+#include <stdexcept>
+#include <type_traits>
 #include "Constants.h"
+#include "PageCodec.h"
+
+const int32_t PAGER_FOOTER_SIZE = 16;
+const int32_t MAX_PAGE_SIZE = 1 << 16;
+
+/// Bumped whenever layout of any file changes
+/// 1 => 64 bit row ids, page numbers and pkeys
+/// 2 => Compressed pages in tagged frames
+const uint32_t FORMAT_VERSION = 2;
 
 class Page{
 public:
+    /// Page size bytes of its file, see Pager::getPageSize
     std::unique_ptr<char[]> buffer;
+
+    /// Fixed width rows decoded from a slotted, pax or compressed page, built on first access, see Table::pageRows
+    std::unique_ptr<char[]> image;
     bool hasUncommitedChanges;
-    int32_t pageNum;
+    row_t pageNum;
 
-    Page(){
-        buffer = std::make_unique<char[]>(PAGE_SIZE);
+    explicit Page(int32_t size = PAGE_SIZE){
+        buffer = std::make_unique<char[]>(size);
         hasUncommitedChanges = false;
         pageNum = 0;
         printf("Page Created\n");
@@ -40,16 +76,34 @@ public:
 
 template <typename page_t>
 class Pager{
+    static constexpr uint32_t FILE_MAGIC = 0x44424d53;
+    static constexpr uint32_t FRAME_MAGIC = 0x5a504744;
+    static constexpr uint32_t FRAME_RAW = 1;
+    static constexpr uint32_t FRAME_COMPRESSED = 2;
+    static constexpr uint32_t PAGE_COMPRESSION = 1;
+    static constexpr int32_t FRAME_HEADER_SIZE = 3 * sizeof(uint32_t);
+
 protected:
     using list_t     = std::list<std::unique_ptr<page_t>>;
     using iterator_t = typename list_t::iterator;
     const int pageLimit;                // Maximum number of pages that can be stored at any time
     int fileDescriptor;                 // File descriptor returned by open system call
     int64_t fileLength;                 // Length of file pointed by fileDescriptor
-    int32_t maxPages;                   // Maximum number of pages this file has
-    std::unordered_map<int32_t, iterator_t> pageMap;
+    row_t maxPages;                     // Maximum number of pages this file has
+    std::unordered_map<row_t, iterator_t> pageMap;
     list_t pageQueue;
+    uint32_t flags;                     // Flags of file footer
+    int32_t pageSize;                   // Bytes of every page of file, from file footer
     bool open(const char* fileName);
+    std::unique_ptr<page_t> newPage() const;
+
+    /// Reads page from file into buffer, decompressing it if needed
+    /// Reading page 0 loads file footer
+    bool readFrame(row_t pageNum, char* buffer);
+
+    /// Writes buffer as page of file, compressing it if needed
+    /// Writing page 0 stores file footer
+    bool writeFrame(row_t pageNum, char* buffer);
 
 public:
     std::unique_ptr<page_t> header;
@@ -61,11 +115,27 @@ public:
     int64_t getFileLength();
     bool getHeader();
     bool close();
-    bool flush(uint32_t pageNum);
+    bool flush(row_t pageNum);
     virtual bool flushPage(page_t* page);
     bool flushAll();
 
-    page_t* read(uint32_t pageNum, std::function<void(page_t*)> callback = nullptr);
+    page_t* read(row_t pageNum, std::function<void(page_t*)> callback = nullptr);
+
+    /// Power of two from PAGE_SIZE to MAX_PAGE_SIZE, set only while file has no pages
+    void setPageSize(int32_t size);
+    int32_t getPageSize() const;
+    static bool isValidPageSize(int32_t size);
+
+    /// Pages are compressed, see PAGE COMPRESSION. Set only while file has no pages
+    void setPageCompression(bool enabled);
+    bool hasPageCompression() const;
+
+    /// Bytes page n takes in file, starting at n * getFrameSize()
+    int32_t getFrameSize() const;
+
+    /// Decodes a frame read directly from file into buffer, e.g. by ExternalSort
+    /// false -> frame is corrupt
+    bool decodeFrame(const char* frame, char* buffer) const;
 };
 
 #include "../Pager.cpp"
@@ -0,0 +1,41 @@
+#ifndef DBMS_PAXPAGE_H
+#define DBMS_PAXPAGE_H
+
+/// ---------------- CLASS DESCRIPTION ----------------
+/// PaxPage reads and writes data pages of a table with pax layout
+/// A page holds as many rows as a fixed width page, but values of each column are
+/// stored together in a minipage so that a scan filtering on a column reads only it
+///
+/// ------------------ PAGE LAYOUT ------------------
+/// 1. Column 1 values      =>  slotsPerPage x size of column 1
+/// 2. Column 2 values      =>  slotsPerPage x size of column 2
+/// ...
+/// n. pkey values          =>  slotsPerPage x pkey_t
+///
+/// Slot s of page holds row (page - 1) * slotsPerPage + s like fixed width rows
+
+#include <vector>
+#include "Constants.h"
+
+class PaxPage{
+    std::vector<uint32_t> fieldOffsets;     // Offset of column in fixed width row, pkey is last field
+    std::vector<uint32_t> fieldSizes;
+    int32_t rowSize;
+    int32_t numSlots;
+
+public:
+    PaxPage(const std::vector<uint32_t>& columnSizes, int32_t pageSize);
+
+    int32_t slotsPerPage() const;
+
+    /// Values of column in slot order, index of pkey is number of columns
+    const char* column(const char* page, int32_t index) const;
+
+    /// Transposes page into slotsPerPage fixed width rows
+    void expand(const char* page, char* rows) const;
+
+    void write(char* page, int32_t slot, const char* row) const;
+    void read(const char* page, int32_t slot, char* row) const;
+};
+
+#endif //DBMS_PAXPAGE_H
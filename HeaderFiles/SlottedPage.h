@@ -0,0 +1,62 @@
+#ifndef DBMS_SLOTTEDPAGE_H
+#define DBMS_SLOTTEDPAGE_H
+
+/// ---------------- CLASS DESCRIPTION ----------------
+/// SlottedPage reads and writes data pages of a table with slotted layout
+/// Rows are stored variable length, a string column only takes its actual length
+///
+/// ------------------ PAGE LAYOUT ------------------
+/// 1. Data start           =>  int32_t  (Lowest offset used by rows, 0 on a new page)
+/// 2. Used bytes           =>  int32_t  (Sum of lengths of live rows)
+/// 3. Slot directory       =>  slotsPerPage x (uint16_t offset, uint16_t length), length 0 if slot is free
+/// 4. Free space
+/// 5. Rows                 =>  Packed from end of page towards directory
+///
+/// ------------------ ROW ENCODING ------------------
+/// Columns in table order, int/float/char/bool as in fixed width row,
+/// string as uint16_t length followed by its bytes, then pkey
+///
+/// Slot s of page holds row (page - 1) * slotsPerPage + s so row numbers map to pages
+/// like fixed width rows. Rows are decoded to fixed width images for the rest of the
+/// executor, see Table::pageRows
+
+#include <vector>
+#include "DataTypes.h"
+#include "Constants.h"
+
+class SlottedPage{
+    static constexpr int32_t HEADER_SIZE = 2 * sizeof(int32_t);
+    static constexpr int32_t SLOT_SIZE = 2 * sizeof(uint16_t);
+
+    std::vector<DataType> columnTypes;
+    std::vector<uint32_t> columnSizes;
+    int32_t pageSize;
+    int32_t rowSize;                    // Fixed width row size
+    int32_t maxEncodedSize;             // Largest encoded row
+    int32_t numSlots;
+
+    int32_t encode(const char* row, char* out) const;
+    void decode(const char* in, char* row) const;
+    void compact(char* page) const;
+
+public:
+    SlottedPage(const std::vector<DataType>& columnTypes_, const std::vector<uint32_t>& columnSizes_, int32_t pageSize_);
+
+    int32_t slotsPerPage() const;
+
+    /// True if any row fits in page
+    bool hasRoom(const char* page) const;
+
+    /// Decodes every slot of page into slotsPerPage fixed width rows, free slots are zeroed
+    void expand(const char* page, char* rows) const;
+
+    /// Encodes fixed width row into slot, false if page can't hold it
+    bool write(char* page, int32_t slot, const char* row) const;
+
+    /// Decodes slot into fixed width row, false if slot is free
+    bool read(const char* page, int32_t slot, char* row) const;
+
+    void erase(char* page, int32_t slot) const;
+};
+
+#endif //DBMS_SLOTTEDPAGE_H
@@ -0,0 +1,42 @@
+#ifndef DBMS_SORTKEY_H
+#define DBMS_SORTKEY_H
+
+#include <string>
+#include <vector>
+#include "DataTypes.h"
+#include "Constants.h"
+
+/// Column of a sort key
+struct SortColumn{
+    DataType type;
+    int32_t offset;                         /// Offset of column in row
+    int32_t size;                           /// Bytes of column in row
+    bool descending = false;
+};
+
+/// Sort keys are normalized so that any two keys compare with memcmp
+/// 1. Int    => Big endian with sign bit flipped
+/// 2. Float  => Big endian with sign bit flipped, all bits flipped for negative numbers
+/// 3. Char   => Sign bit flipped
+/// 4. Bool   => As is
+/// 5. String => Bytes up to terminator, zero padded to column size
+/// Columns of a composite key are concatenated, all bits of a descending column are inverted
+class SortKey{
+public:
+    std::vector<SortColumn> columns;
+    int32_t width = 0;                      /// Bytes of normalized key
+
+    SortKey() = default;
+    explicit SortKey(std::vector<SortColumn> columns_);
+
+    /// Writes normalized key of row into key
+    void encode(const char* row, char* key) const;
+
+    /// Writes normalized bytes of one column from its fixed width value, e.g. a bound of a key range
+    void encodeValue(size_t column, const char* value, char* key) const;
+
+    /// Values of columns of a normalized key, used for debugging
+    std::vector<std::string> decode(const char* key) const;
+};
+
+#endif //DBMS_SORTKEY_H
@@ -10,8 +10,14 @@
 #include <vector>
 #include <map>
 #include "Pager.h"
+#include "FreeSpaceMap.h"
+#include "SlottedPage.h"
+#include "PaxPage.h"
+#include "CompressedPage.h"
 #include "DataTypes.h"
 #include "BTree.h"
+#include "ClusteredTree.h"
+#include "CoveringIndex.h"
 #include "Constants.h"
 
 class Table;
@@ -30,6 +36,7 @@ public:
 
     /// This is true if cursor is pointing to last row
     /// calling operator++ at this point won't increase row further
+    /// Deleted slots are not skipped, use TableScan for that
     bool endOfTable;
 
     explicit Cursor(Table* table);
@@ -43,8 +50,10 @@ public:
     /// Step4: It returns pointer to that row in memory location
     char* value();
 
-    void addedChangesToCommit();
-    void commitChanges();
+    /// Marks page dirty. Returns false if changed row no longer fits in a slotted page,
+    /// row is left unchanged then, see Table::relocateRow
+    bool addedChangesToCommit();
+    bool commitChanges();
 };
 
 #define BTREE_HANDLER(res, tree, handler)                                    \
@@ -65,20 +74,48 @@ public:
         break;
 
 
+/// Format of data pages of a table, chosen at creation
+enum class TableLayout: int32_t{
+    rows,                   /// Fixed width rows back to back
+    slotted,                /// Slot directory and variable length rows, see SlottedPage
+    pax,                    /// Values of each column stored together within a page, see PaxPage
+    compressed,             /// Pax with every column of a page encoded, see CompressedPage
+    clustered               /// Rows in leaves of a B+ tree in key order, see ClusteredTree
+};
+
+/// Storage options of a table chosen at creation
+struct TableOptions{
+    TableLayout layout = TableLayout::rows;
+    bool pageCompression = false;           /// Pages of table and its indexes are compressed on disk
+    int32_t pageSize = PAGE_SIZE;           /// Page size of table file, index files keep PAGE_SIZE
+    int32_t clusterColumn = -1;             /// Clustered layout, column whose unique values order rows, -1 => pkey
+};
+
 class Table{
     friend class Cursor;
+    friend class BatchScanner;
     friend class TableManager;
     int32_t rowSize;
     int32_t rowsPerPage;
     row_t numRows = 0;
-    // int32_t rowStackPtr;
-    // int32_t rowStackOffset;
 
-    row_t* rowStack;
-    int32_t stackSize;
+    /// Deleted row slots, reused by inserts
+    /// In slotted layout unused slots of full pages are also kept here so scans skip them
+    std::unique_ptr<FreeSpaceMap> freeMap;
+
+    TableLayout layout;
+    std::unique_ptr<SlottedPage> slotted;
+    std::unique_ptr<PaxPage> pax;
+    std::unique_ptr<CompressedPage> compressed;
+    row_t firstPageWithRoom;                // Slotted layout, no data page before this can take a row
+    std::unique_ptr<ClusteredTree> clustered;
+    int32_t clusterColumn;                  // Clustered layout, -1 => rows are ordered on pkey
+    row_t clusterRoot;
+    int32_t leafRowsOffset;                 // Clustered layout, offset of first row in a leaf
 
     bool tableOpen;
     std::string tableName;
+    std::string fileName;
 
 public:
     bool tableIsIndexed;
@@ -88,37 +125,62 @@ public:
     std::vector<std::string> columnNames;
     std::vector<DataType> columnTypes;
     std::vector<uint32_t> columnSizes;
+    std::vector<uint32_t> columnOffsets;
     std::map<std::string, int> columnIndex;
     std::vector<bool> indexed;
     std::unique_ptr<Pager<Page>> pager;
     std::vector<int32_t> stackPtr;
     std::vector<std::unique_ptr<BPlusTreeBase>> trees;
+    std::vector<std::unique_ptr<CoveringIndex>> coveringIndexes;    /// By first key column, nullptr if column has none
 
     Table(std::string tableName, const std::string& fileName);
     ~Table();
 
     bool close();
+    bool flushAll();
     void storeMetadata();
     void loadMetadata();
-    void createColumns(std::vector<std::string>&& columnNames, std::vector<DataType>&& columnTypes, std::vector<uint32_t>&& columnSizes);
+    void createColumns(std::vector<std::string>&& columnNames, std::vector<DataType>&& columnTypes, std::vector<uint32_t>&& columnSizes,
+                       const TableOptions& options = TableOptions());
 
+    const std::string& getTableName() const;
+    const std::string& getFileName() const;
     int32_t getRowSize() const;
+    int32_t getRowsPerPage() const;
+    TableLayout getLayout() const;
+    int32_t getClusterColumn() const;
+    void expandPage(const char* page, char* rows) const;
+    char* pageRows(Page* page);
+    bool storeRow(Page* page, row_t row);
+    row_t getNumRows() const;
+    row_t numSlots() const;
+    std::vector<row_t> freeRowLocations() const;
     void increaseRowCount();
     row_t nextFreeRowLocation();
     void addFreeRowLocation(row_t location);
     bool deleteRow(row_t row);
+    row_t relocateRow(row_t row, const char* image);
+    row_t insertClustered(const char* row);
     bool insertBTree(std::vector<std::string>& data, row_t row);
     bool removeBTree(int index, std::string& key);
     bool updateBTree(std::vector<std::string>& data, row_t row);
+    bool updateCovering(const char* oldImage, row_t oldRow, const char* newImage, row_t newRow);
+    BPlusTreeBase* index(int32_t column) const;
+    CoveringIndex* coveringIndex(int32_t column) const;
     Cursor start();
     Cursor end();
 
 private:
     void createColumnIndex();
     bool createIndex(int index, const std::string& filename);
+    bool createCoveringIndex(std::vector<int32_t> keyColumns, std::vector<int32_t> included, const std::string& filename);
     void calculateRowInfo();
     void serailizeColumnMetadata(char* buffer);
     void deSerailizeColumnMetadata(char* buffer);
+    row_t nextSlottedLocation();
+    bool freeSlot(row_t row);
+    void setFirstPageWithRoom(row_t page);
+    void setClusterRoot(row_t root);
 };
 
 #endif //DBMS_TABLE_H
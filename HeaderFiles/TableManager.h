@@ -20,6 +20,9 @@
 /// ---------------- FILE NAMING SCHEME ----------------
 /// 1. Base Table => <baseURL>/<table-name>.db
 /// 2. Index on col => <baseURL>/<table-name>_<col-number>.idx
+/// 3. Free rows of table => <baseURL>/<table-name>.fsm
+/// 4. Free pages of index => <baseURL>/indexes/<table-name>_<col-number>.fsm
+/// 5. Composite or covering index => <baseURL>/indexes/<table-name>_<first-key-col-number>.cov
 
 enum class TableManagerResult{
     tableNotFound,
@@ -36,7 +39,9 @@ enum class TableManagerResult{
 
 enum class TableFileType{
     indexFile,
-    baseTable
+    baseTable,
+    freeSpaceMap,
+    coveringIndex
 };
 
 class TableManager {
@@ -62,12 +67,16 @@ public:
     TableManagerResult create(const std::string &tableName,
                               std::vector<std::string> &&columnNames_,
                               std::vector<DataType> &&columnTypes_,
-                              std::vector<uint32_t> &&columnSize_);
+                              std::vector<uint32_t> &&columnSize_,
+                              const TableOptions& options = TableOptions());
 
     TableManagerResult drop(const std::string &tableName);
 
     TableManagerResult close(const std::string &tableName);
     bool createIndex(std::shared_ptr<Table>& table, int32_t index);
+
+    /// Composite index on key columns storing values of included columns, see CoveringIndex
+    bool createCoveringIndex(std::shared_ptr<Table>& table, const std::vector<int32_t>& keyColumns, const std::vector<int32_t>& included);
     TableManagerResult closeAll();
     void flushAll();
 
@@ -0,0 +1,317 @@
+/// ---------------- CLASS DESCRIPTION ----------------
+/// Equi-join of two tables on one column of each
+/// 1. sortMerge       => Both join columns indexed. Leaf chains are merged in key order
+/// 2. indexNestedLoop => One join column indexed. Other table is scanned and probes the index
+/// 3. hash            => No index. Smaller table is hashed in memory and other table probes it
+///                       If it doesn't fit in JOIN_MEMORY_LIMIT both tables are partitioned
+///                       on disk by hash of key and each partition pair is joined (grace hash join)
+///
+/// JoinPlanner estimates cost of each applicable strategy in page reads and picks cheapest
+
+#include <cmath>
+#include <unordered_map>
+#include "HeaderFiles/ExternalSort.h"
+
+enum class JoinStrategy{
+    sortMerge,
+    indexNestedLoop,
+    hash
+};
+
+struct JoinPlan{
+    JoinStrategy strategy = JoinStrategy::hash;
+
+    /// indexNestedLoop => true if left table is the probed (inner) side
+    /// hash            => true if left table is the build side
+    bool leftIsInner = false;
+    double cost = 0;
+};
+
+/// Extracts join key of a serialized row as bytes comparable across tables
+/// Strings are cut at their terminator so string(10) and string(20) columns can be joined
+inline std::string joinKey(const char* row, DataType type, int32_t offset, int32_t size){
+    const char* data = row + offset;
+    if(type == DataType::String) return std::string(data, strnlen(data, size));
+    return std::string(data, size);
+}
+
+/// In memory hash table on join column of build side
+/// Build rows are copied in so probing does no heap reads on build side
+class JoinHashTable{
+    std::unordered_map<std::string, std::vector<int64_t>> buckets;     /// key => offsets of rows in rows
+    std::vector<char> rows;
+    DataType keyType;
+    int32_t keyOffset;
+    int32_t keySize;
+    int32_t rowSize;
+
+public:
+    JoinHashTable(DataType keyType_, int32_t keyOffset_, int32_t keySize_, int32_t rowSize_){
+        keyType = keyType_;
+        keyOffset = keyOffset_;
+        keySize = keySize_;
+        rowSize = rowSize_;
+    }
+
+    void insert(const char* row){
+        int64_t offset = rows.size();
+        rows.insert(rows.end(), row, row + rowSize);
+        buckets[joinKey(row, keyType, keyOffset, keySize)].push_back(offset);
+    }
+
+    /// Calls callback with every build row having given key
+    template <typename callback_t>
+    bool probe(const std::string& key, const callback_t& callback){
+        auto itr = buckets.find(key);
+        if(itr == buckets.end()) return true;
+        for(int64_t offset: itr->second){
+            if(!callback(rows.data() + offset)) return false;
+        }
+        return true;
+    }
+
+    /// Approximate bytes held including bucket overhead
+    int64_t memoryUsage() const{
+        return rows.size() + buckets.size() * (keySize + 64);
+    }
+
+    /// Upper bound of memoryUsage per inserted row
+    static int64_t bytesPerRow(int32_t rowSize, int32_t keySize){
+        return rowSize + keySize + 64;
+    }
+
+    void clear(){
+        buckets.clear();
+        rows.clear();
+    }
+};
+
+/// Spill buffer size for each of given number of partitions, a multiple of rowSize
+/// Every partition has two buffers and together they stay within SPILL_MEMORY_LIMIT
+inline int64_t spillBlockSize(int32_t rowSize, int32_t partitions){
+    int64_t rows = (SPILL_MEMORY_LIMIT / 2) / ((int64_t)partitions * rowSize);
+    rows = std::min<int64_t>(rows, SPILL_BLOCK_SIZE / rowSize);
+    return std::max<int64_t>(1, rows) * rowSize;
+}
+
+/// Start of names of spill files of one operator, in temp directory of options
+/// Process id and a sequence number keep files of operators in flight and of other processes apart
+inline std::string spillFilePrefix(const SortOptions& options, const std::string& name){
+    static int64_t sequence = 0;
+    return options.tempDirectory + "/_" + name + "_" + std::to_string(getpid()) + "_" + std::to_string(sequence++);
+}
+
+/// Iterates rows of a partition written by SpillWriter
+class SpillScan{
+    SpillReader reader;
+    int32_t rowSize;
+    int64_t offset = 0;
+
+public:
+    SpillScan(const std::string& fileName, int32_t rowSize_, int64_t blockSize){
+        rowSize = rowSize_;
+        reader.setAsync(true);
+        if(!reader.initialise(fileName.c_str(), blockSize)) throw std::runtime_error("Error opening file");
+    }
+
+    char* next(){
+        if(offset == reader.bufferSize){
+            offset = 0;
+            if(reader.fetchInput() <= 0) return nullptr;
+        }
+        char* row = reader.primaryInputBuffer.get() + offset;
+        offset += rowSize;
+        return row;
+    }
+};
+
+class HashJoin{
+public:
+    /// Number of partitions of build table needed so that each one fits in JOIN_MEMORY_LIMIT
+    /// 1 means build table is hashed in memory directly
+    static int32_t partitionsNeeded(Table* build, int32_t buildIndex){
+        double bytes = build->getNumRows() * JoinHashTable::bytesPerRow(build->getRowSize(), build->columnSizes[buildIndex]);
+        if(bytes <= JOIN_MEMORY_LIMIT) return 1;
+        // Leave room for skew between partitions
+        return std::min<int32_t>(JOIN_MAX_PARTITIONS, std::ceil(1.25 * bytes / JOIN_MEMORY_LIMIT));
+    }
+
+    /// Builds hash table on build table and probes it with probe table
+    /// Callback gets (build row, probe row). Partitions are spilled to temp directory of options
+    template <typename callback_t>
+    static bool run(Table* build, int32_t buildIndex, Table* probe, int32_t probeIndex, const callback_t& callback,
+                    const SortOptions& options = SortOptions()){
+        int32_t partitions = partitionsNeeded(build, buildIndex);
+        if(partitions > 1) return runGrace(build, buildIndex, probe, probeIndex, partitions, callback, options);
+
+        JoinHashTable hashTable(build->columnTypes[buildIndex], build->columnOffsets[buildIndex],
+                                build->columnSizes[buildIndex], build->getRowSize());
+        TableScan buildScan(build, {});
+        return buildAndProbe(hashTable, buildScan, [&](){ return TableScan(probe, {}); }, probe, probeIndex, callback);
+    }
+
+private:
+    /// Both tables are split into partitions by hash of join key so matching rows land in same partition pair
+    /// Spill buffers of all partitions together stay within SPILL_MEMORY_LIMIT
+    /// Partitions are named <prefix>_<side>_<partition>, see spillFilePrefix
+    template <typename callback_t>
+    static bool runGrace(Table* build, int32_t buildIndex, Table* probe, int32_t probeIndex, int32_t partitions,
+                         const callback_t& callback, const SortOptions& options){
+        std::filesystem::create_directories(options.tempDirectory);
+        std::string prefix = spillFilePrefix(options, "join_" + build->getTableName() + "_" + probe->getTableName());
+        std::vector<std::string> buildFiles(partitions), probeFiles(partitions);
+        for(int32_t i = 0; i < partitions; ++i){
+            buildFiles[i] = prefix + "_build_" + std::to_string(i);
+            probeFiles[i] = prefix + "_probe_" + std::to_string(i);
+        }
+        auto removeFiles = [&](){
+            std::error_code error;
+            for(int32_t i = 0; i < partitions; ++i){
+                std::filesystem::remove(buildFiles[i], error);
+                std::filesystem::remove(probeFiles[i], error);
+            }
+        };
+
+        // Spill I/O throws, partitions are removed before error is passed on
+        bool res;
+        try{
+            res = partition(build, buildIndex, buildFiles) && partition(probe, probeIndex, probeFiles);
+            for(int32_t i = 0; res && i < partitions; ++i){
+                JoinHashTable hashTable(build->columnTypes[buildIndex], build->columnOffsets[buildIndex],
+                                        build->columnSizes[buildIndex], build->getRowSize());
+                SpillScan buildScan(buildFiles[i], build->getRowSize(), spillBlockSize(build->getRowSize(), 1));
+                res = buildAndProbe(hashTable, buildScan, [&](){
+                    return SpillScan(probeFiles[i], probe->getRowSize(), spillBlockSize(probe->getRowSize(), 1));
+                }, probe, probeIndex, callback);
+            }
+        }
+        catch(...){
+            removeFiles();
+            throw;
+        }
+        removeFiles();
+        return res;
+    }
+
+    static int32_t partitionOf(const std::string& key, int32_t partitions){
+        // Mix bits so partitioning isn't correlated with buckets of JoinHashTable which use the same hash
+        uint64_t hash = std::hash<std::string>{}(key);
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash % partitions;
+    }
+
+    static bool partition(Table* table, int32_t index, const std::vector<std::string>& fileNames){
+        int32_t partitions = fileNames.size();
+        int32_t rowSize = table->getRowSize();
+        DataType type = table->columnTypes[index];
+        int32_t offset = table->columnOffsets[index];
+        int32_t size = table->columnSizes[index];
+
+        std::vector<std::unique_ptr<SpillWriter>> writers(partitions);
+        for(int32_t i = 0; i < partitions; ++i){
+            writers[i] = std::make_unique<SpillWriter>();
+            if(!writers[i]->initialise(fileNames[i].c_str(), spillBlockSize(rowSize, partitions))) return false;
+        }
+
+        TableScan scan(table, {});
+        while(char* row = scan.next()){
+            writers[partitionOf(joinKey(row, type, offset, size), partitions)]->append(row, rowSize);
+        }
+        for(auto& writer: writers) writer->flushRemaining();
+        return true;
+    }
+
+    /// Hashes build rows and probes them with a fresh probe scan
+    /// If build rows don't fit in JOIN_MEMORY_LIMIT they are hashed in chunks
+    /// and probe side is scanned once per chunk
+    template <typename build_scan_t, typename probe_scan_factory_t, typename callback_t>
+    static bool buildAndProbe(JoinHashTable& hashTable, build_scan_t& buildScan, const probe_scan_factory_t& probeScanFactory,
+                              Table* probe, int32_t probeIndex, const callback_t& callback){
+        DataType probeType = probe->columnTypes[probeIndex];
+        int32_t probeOffset = probe->columnOffsets[probeIndex];
+        int32_t probeSize = probe->columnSizes[probeIndex];
+
+        bool buildExhausted = false;
+        while(!buildExhausted){
+            hashTable.clear();
+            row_t chunkRows = 0;
+            while(hashTable.memoryUsage() < JOIN_MEMORY_LIMIT){
+                char* row = buildScan.next();
+                if(row == nullptr){
+                    buildExhausted = true;
+                    break;
+                }
+                hashTable.insert(row);
+                ++chunkRows;
+            }
+            if(chunkRows == 0) break;
+
+            auto probeScan = probeScanFactory();
+            while(char* probeRow = probeScan.next()){
+                std::string key = joinKey(probeRow, probeType, probeOffset, probeSize);
+                bool res = hashTable.probe(key, [&](char* buildRow)->bool{
+                    return callback(buildRow, probeRow);
+                });
+                if(!res) return false;
+            }
+        }
+        return true;
+    }
+};
+
+class JoinPlanner{
+public:
+    static JoinPlan choose(Table* left, int32_t leftIndex, Table* right, int32_t rightIndex){
+        Table* tables[2] = {left, right};
+        int32_t indices[2] = {leftIndex, rightIndex};
+        bool indexed[2];
+        IndexStatistics stats[2];
+        double pages[2], rows[2];
+        for(int side = 0; side < 2; ++side){
+            BPlusTreeBase* tree = tables[side]->index(indices[side]);
+            indexed[side] = (tree != nullptr);
+            if(indexed[side]) stats[side] = tree->statistics();
+            pages[side] = dataPages(tables[side]);
+            rows[side] = tables[side]->getNumRows();
+        }
+
+        // Hash join is always possible. Build on smaller table
+        // Grace hash join reads both tables, writes and reads back their partitions
+        JoinPlan best;
+        int build = (left->getNumRows() <= right->getNumRows()) ? 0 : 1;
+        best.strategy = JoinStrategy::hash;
+        best.leftIsInner = (build == 0);
+        best.cost = pages[build] + pages[1 - build];
+        if(HashJoin::partitionsNeeded(tables[build], indices[build]) > 1) best.cost *= 3;
+
+        // Index nested loop: scan outer, one index probe and heap read per outer row
+        for(int inner = 0; inner < 2; ++inner){
+            if(!indexed[inner]) continue;
+            int outer = 1 - inner;
+            double cost = pages[outer] + rows[outer] * (stats[inner].height + (stats[inner].clustered ? 0 : 1));
+            if(cost < best.cost){
+                best.strategy = JoinStrategy::indexNestedLoop;
+                best.leftIsInner = (inner == 0);
+                best.cost = cost;
+            }
+        }
+
+        // Merge of both leaf chains, every matched row is a heap read on both sides
+        // Leaves of a clustered tree hold rows, not keys of a BPTree to merge with
+        if(indexed[0] && indexed[1] && !stats[0].clustered && !stats[1].clustered){
+            double cost = stats[0].leafPages + stats[1].leafPages + rows[0] + rows[1];
+            if(cost < best.cost){
+                best.strategy = JoinStrategy::sortMerge;
+                best.cost = cost;
+            }
+        }
+        return best;
+    }
+
+private:
+    static double dataPages(Table* table){
+        return std::max<double>(1, (table->numSlots() + table->getRowsPerPage() - 1) / table->getRowsPerPage());
+    }
+};
@@ -0,0 +1,262 @@
+/// ---------------- CLASS DESCRIPTION ----------------
+/// Optimizer chooses how a select reads its table
+/// 1. tableScan      => Batch scan of every page of table
+/// 2. indexLookup    => Equality search in an index, one heap read per match
+/// 3. indexRangeScan => Range of index leaves, one heap read per match
+/// 4. indexOnlyScan  => Range of index leaves when only indexed column is selected
+/// 5. coveringIndexScan => Range of leaves of a covering index when it stores every column
+///                         read by select, records are checked and printed without a heap read
+///
+/// Cost of every path is estimated in page reads using IndexStatistics of
+/// each index and numRows / rowsPerPage of table. Cheapest path is picked.
+/// Leaves of the tree of a clustered table are its rows, matches cost no heap read
+/// A composite index is used when condition compares its first key column, equality on it
+/// and a comparison on second key column make one range of its leaves
+
+enum class AccessPath{
+    tableScan,
+    indexLookup,
+    indexRangeScan,
+    indexOnlyScan,
+    coveringIndexScan
+};
+
+struct AccessPlan{
+    AccessPath path = AccessPath::tableScan;
+    int32_t index = -1;                     /// Column whose index is used
+    BPlusTreeBase* tree = nullptr;          /// Index used, a column may have a covering index besides its index
+    KeyRange range;
+    double selectivity = 1;
+    double cost = 0;
+};
+
+class Optimizer{
+public:
+    /// indices are the selected columns (sorted) when statement does not select all columns
+    static AccessPlan choosePath(Table* table, SelectStatement* statement, const std::vector<int32_t>& indices){
+        AccessPlan best;
+        row_t numRows = table->getNumRows();
+        double dataPages = std::max<double>(1, (table->numSlots() + table->getRowsPerPage() - 1) / table->getRowsPerPage());
+        best.cost = dataPages;
+
+        const Condition& condition = statement->condition;
+        for(int32_t index = 0; index < table->indexed.size(); ++index){
+            const std::string& name = table->columnNames[index];
+            if(!statement->selectAllRows && name != condition.col && name != condition.col2) continue;
+            CoveringIndex* covering = table->coveringIndex(index);
+            for(BPlusTreeBase* tree: {table->index(index), (BPlusTreeBase*)covering}){
+                if(tree == nullptr) continue;
+
+                // Composite key is matched column by column, other indexes have one key column
+                std::vector<int32_t> keyColumns{index};
+                if(tree == covering) keyColumns = covering->getKeyColumns();
+                std::vector<std::string> keyNames;
+                for(int32_t column: keyColumns) keyNames.push_back(table->columnNames[column]);
+                KeyRange range;
+                bool exact = true;
+                if(!statement->selectAllRows && !buildRange(condition, keyNames, range, exact)) continue;
+
+                // Residual predicates are checked on covered columns of leaf records
+                bool covered = statement->selectAllCols
+                        ? coversAll(tree, (int32_t)table->columnNames.size())
+                        : std::all_of(indices.begin(), indices.end(), [&](int32_t i){ return tree->covers(i); });
+
+                // Leaves have no row to check residual predicates on
+                bool indexOnly = !covered && exact && !statement->selectAllCols &&
+                        std::all_of(indices.begin(), indices.end(), [&](int32_t i){ return i == index; });
+                if(statement->selectAllRows && !indexOnly && !covered) continue;
+
+                IndexStatistics stats = tree->statistics();
+                double selectivity = estimateSelectivity(table, keyColumns, stats, range, numRows);
+                double matchedRows = selectivity * numRows;
+                double leafCost = stats.height + selectivity * stats.leafPages;
+
+                AccessPlan plan;
+                plan.index = index;
+                plan.tree = tree;
+                plan.range = range;
+                plan.selectivity = selectivity;
+                if(covered){
+                    plan.path = AccessPath::coveringIndexScan;
+                    plan.cost = leafCost;
+                }
+                else if(indexOnly){
+                    plan.path = AccessPath::indexOnlyScan;
+                    plan.cost = leafCost;
+                }
+                else{
+                    bool isLookup = range.hasLow && range.hasHigh && range.lowInclusive && range.highInclusive && range.low == range.high;
+                    plan.path = isLookup ? AccessPath::indexLookup : AccessPath::indexRangeScan;
+                    plan.cost = leafCost;
+                    if(!stats.clustered) plan.cost += matchedRows;     // Every match is a random heap read
+                }
+                if(plan.cost < best.cost) best = plan;
+            }
+        }
+        return best;
+    }
+
+    /// Converts condition into a key range
+    /// exact is false if some comparison is left for residual predicates
+    /// Returns false if no comparison bounds the range e.g. `!=`
+    static bool buildRange(const Condition& condition, KeyRange& range, bool& exact){
+        return buildRange(condition, {condition.col}, range, exact);
+    }
+
+    /// Converts condition into a range of an index keyed on keyColumns
+    /// Equalities on leading key columns become prefix of range, comparisons on next key column its bounds
+    static bool buildRange(const Condition& condition, const std::vector<std::string>& keyColumns, KeyRange& range, bool& exact){
+        struct Comparison{
+            const std::string& col;
+            ComparisonType compType;
+            const std::string& data;
+            bool used;
+        };
+        std::vector<Comparison> comparisons{{condition.col, condition.compType1, condition.data1, false}};
+        if(condition.isCompound) comparisons.push_back({condition.col2, condition.compType2, condition.data2, false});
+
+        for(const std::string& column: keyColumns){
+            auto equality = std::find_if(comparisons.begin(), comparisons.end(), [&](const Comparison& comparison){
+                return comparison.col == column && comparison.compType == ComparisonType::equal;
+            });
+            if(equality != comparisons.end()){
+                range.prefix.push_back(equality->data);
+                equality->used = true;
+                continue;
+            }
+            for(auto& comparison: comparisons){
+                if(!comparison.used && comparison.col == column) comparison.used = addBound(comparison.compType, comparison.data, range);
+            }
+            break;
+        }
+
+        // Range without bounds on column after prefix is an equality on last prefix column
+        if(!range.prefix.empty() && !range.hasLow && !range.hasHigh){
+            range.hasLow = range.hasHigh = true;
+            range.low = range.high = range.prefix.back();
+            range.prefix.pop_back();
+        }
+        exact = std::all_of(comparisons.begin(), comparisons.end(), [](const Comparison& comparison){ return comparison.used; });
+        return range.hasLow || range.hasHigh;
+    }
+
+private:
+    static bool coversAll(BPlusTreeBase* tree, int32_t numColumns){
+        for(int32_t column = 0; column < numColumns; ++column){
+            if(!tree->covers(column)) return false;
+        }
+        return true;
+    }
+
+    /// A second bound on an already bounded side is left to residual predicates
+    /// Returns false if comparison was not captured by range
+    static bool addBound(ComparisonType compType, const std::string& data, KeyRange& range){
+        bool setLow = false, setHigh = false, inclusive = true;
+        switch(compType){
+            case ComparisonType::equal:
+                setLow = setHigh = true;
+                break;
+            case ComparisonType::greaterThan:
+                inclusive = false;
+                [[fallthrough]];
+            case ComparisonType::greaterThanOrEqual:
+                setLow = true;
+                break;
+            case ComparisonType::lessThan:
+                inclusive = false;
+                [[fallthrough]];
+            case ComparisonType::lessThanOrEqual:
+                setHigh = true;
+                break;
+            default:
+                return false;
+        }
+        if((setLow && range.hasLow) || (setHigh && range.hasHigh)) return false;
+        if(setLow){
+            range.hasLow = true;
+            range.low = data;
+            range.lowInclusive = inclusive;
+        }
+        if(setHigh){
+            range.hasHigh = true;
+            range.high = data;
+            range.highInclusive = inclusive;
+        }
+        return true;
+    }
+
+    /// Key distribution is known for first key column only, later columns use textbook constants
+    static double estimateSelectivity(Table* table, const std::vector<int32_t>& keyColumns, const IndexStatistics& stats,
+                                      const KeyRange& range, row_t numRows){
+        auto levelRange = [&](size_t level){
+            KeyRange result;
+            if(level < range.prefix.size()){
+                result.hasLow = result.hasHigh = true;
+                result.low = result.high = range.prefix[level];
+            }
+            else{
+                result = range;
+                result.prefix.clear();
+            }
+            return result;
+        };
+        double selectivity = estimateSelectivity(table->columnTypes[keyColumns[0]], stats, levelRange(0), numRows);
+        for(size_t level = 1; level <= range.prefix.size(); ++level){
+            selectivity *= estimateSelectivity(table->columnTypes[keyColumns[level]], IndexStatistics(), levelRange(level), numRows);
+        }
+        return selectivity;
+    }
+
+    static double estimateSelectivity(DataType type, const IndexStatistics& stats, const KeyRange& range, row_t numRows){
+        if(numRows <= 0) return 0;
+        if(!range.hasLow && !range.hasHigh) return 1;
+        bool isEquality = range.hasLow && range.hasHigh && range.low == range.high;
+
+        double low, high;
+        if(!stats.hasBounds || !stats.isNumeric ||
+           (range.hasLow && !toNumeric(type, range.low, low)) ||
+           (range.hasHigh && !toNumeric(type, range.high, high))){
+            // Without key distribution fall back to textbook constants
+            if(isEquality) return (type == DataType::Bool) ? 0.5 : 0.05;
+            return (range.hasLow && range.hasHigh) ? 0.25 : 0.33;
+        }
+
+        double span = stats.maxKey - stats.minKey;
+        if(!range.hasLow) low = stats.minKey;
+        if(!range.hasHigh) high = stats.maxKey;
+        if(high < stats.minKey || low > stats.maxKey || high < low) return 0;
+
+        if(isEquality){
+            // Integral keys can't have more distinct values than their span
+            double distinct = numRows;
+            if(type == DataType::Int || type == DataType::Char || type == DataType::Bool){
+                distinct = std::min<double>(numRows, span + 1);
+            }
+            return 1.0 / std::max<double>(1, distinct);
+        }
+        if(span <= 0) return 1;
+        double covered = std::min(high, stats.maxKey) - std::max(low, stats.minKey);
+        return std::min(1.0, std::max(1.0 / numRows, covered / span));
+    }
+
+    static bool toNumeric(DataType type, const std::string& data, double& value){
+        try{
+            switch(type){
+                case DataType::Int:
+                case DataType::Float:
+                    value = std::stod(data);
+                    return true;
+                case DataType::Char:
+                    value = data.empty() ? 0 : data[0];
+                    return true;
+                case DataType::Bool:
+                    value = (data == "true");
+                    return true;
+                case DataType::String:
+                    return false;
+            }
+        }
+        catch(...){}
+        return false;
+    }
+};
@@ -0,0 +1,200 @@
+/// ---------------- CLASS DESCRIPTION ----------------
+/// Ordering of select rows for `order by <col> [asc|desc] limit <n>`
+/// 1. indexOrder   => Leaves of index on order column are walked forwards, or backwards
+///                    through leftSibling_ for desc. Reading stops once limit rows are out
+/// 2. topK         => limit rows fit in SORT_MEMORY_LIMIT. A bounded heap of limit rows
+///                    is kept over a table scan
+/// 3. memorySort   => All rows fit in SORT_MEMORY_LIMIT. Rows are copied and sorted
+/// 4. externalSort => TableSort sorts (normalized key, row) of whole table on disk.
+///                    Desc is encoded in key. Rows are read back in that order and
+///                    checked against condition
+///
+/// Emit callback returns false to stop reading e.g. when limit is reached
+
+enum class OrderStrategy{
+    indexOrder,
+    topK,
+    memorySort,
+    externalSort
+};
+
+struct OrderPlan{
+    OrderStrategy strategy = OrderStrategy::memorySort;
+    KeyRange range;                 /// Range of order index for indexOrder
+};
+
+/// Orders rows by one column, true if a comes before b
+class RowOrder{
+    DataType type;
+    int32_t offset;
+    int32_t size;
+    bool descending;
+
+public:
+    RowOrder(Table* table, int32_t index, bool descending_){
+        type = table->columnTypes[index];
+        offset = table->columnOffsets[index];
+        size = table->columnSizes[index];
+        descending = descending_;
+    }
+
+    bool operator()(const char* a, const char* b) const{
+        int res = compareColumn(a + offset, b + offset, type, size);
+        return descending ? res > 0 : res < 0;
+    }
+};
+
+class OrderBy{
+public:
+    static OrderPlan choose(Table* table, SelectStatement* statement, int32_t orderIndex){
+        OrderPlan plan;
+        int64_t numRows = table->getNumRows();
+        int64_t rowSize = table->getRowSize();
+        int64_t limit = statement->limit;
+        double dataPages = std::max<double>(1, (table->numSlots() + table->getRowsPerPage() - 1) / table->getRowsPerPage());
+
+        if(limit >= 0 && limit * rowSize <= SORT_MEMORY_LIMIT) plan.strategy = OrderStrategy::topK;
+        else if(numRows * rowSize <= SORT_MEMORY_LIMIT) plan.strategy = OrderStrategy::memorySort;
+        else plan.strategy = OrderStrategy::externalSort;
+        double sortCost = dataPages * (plan.strategy == OrderStrategy::externalSort ? 3 : 1);
+
+        // Index order reads one heap page per row, but only until limit
+        // Leaves of a clustered table hold the rows, a page of them costs one read
+        BPlusTreeBase* tree = table->index(orderIndex);
+        if(tree == nullptr) return plan;
+        bool exact = true;
+        KeyRange range;
+        if(!statement->selectAllRows && statement->condition.col == statement->orderBy){
+            Optimizer::buildRange(statement->condition, range, exact);
+        }
+        IndexStatistics stats = tree->statistics();
+        double rowsRead = (limit >= 0) ? std::min<double>(limit, numRows) : numRows;
+        double rowCost = stats.clustered ? stats.leafPages / std::max<double>(1, numRows) : 1;
+        double indexCost = stats.height + rowsRead * rowCost;
+        if(indexCost <= sortCost){
+            plan.strategy = OrderStrategy::indexOrder;
+            plan.range = range;
+        }
+        return plan;
+    }
+
+    template <typename emit_t>
+    static bool run(Table* table, SelectStatement* statement, int32_t orderIndex,
+                    const std::vector<PredicateKernel>& kernels, const emit_t& emit){
+        OrderPlan plan = choose(table, statement, orderIndex);
+        switch(plan.strategy){
+            case OrderStrategy::indexOrder:
+                return indexOrder(table, statement, orderIndex, plan.range, kernels, emit);
+            case OrderStrategy::topK:
+                return topK(table, statement, orderIndex, kernels, emit);
+            case OrderStrategy::memorySort:
+                return memorySort(table, statement, orderIndex, kernels, emit);
+            case OrderStrategy::externalSort:
+                return externalSort(table, statement, orderIndex, kernels, emit);
+        }
+        return false;
+    }
+
+private:
+    static bool matches(const char* row, const std::vector<PredicateKernel>& kernels){
+        for(auto& kernel: kernels){
+            if(!kernel.matches(row)) return false;
+        }
+        return true;
+    }
+
+    /// Fetches row by row number, nullptr if page can't be read
+    static char* fetch(Table* table, row_t row){
+        Cursor cursor(table);
+        cursor.row = row;
+        return cursor.value();
+    }
+
+    template <typename emit_t>
+    static bool indexOrder(Table* table, SelectStatement* statement, int32_t orderIndex, const KeyRange& range,
+                           const std::vector<PredicateKernel>& kernels, const emit_t& emit){
+        bool stopped = false;
+        auto callback = [&](row_t row)->bool{
+            char* buffer = fetch(table, row);
+            if(buffer == nullptr) return false;
+            if(!matches(buffer, kernels)) return true;
+            stopped = !emit(buffer);
+            return !stopped;
+        };
+        BPlusTreeBase* tree = table->index(orderIndex);
+        bool res = statement->descending ? tree->rangeScanReverse(range, callback) : tree->rangeScan(range, callback);
+        return res || stopped;
+    }
+
+    /// Heap top is the row that comes last, it is replaced by any row that comes before it
+    template <typename emit_t>
+    static bool topK(Table* table, SelectStatement* statement, int32_t orderIndex,
+                     const std::vector<PredicateKernel>& kernels, const emit_t& emit){
+        int64_t limit = statement->limit;
+        if(limit == 0) return true;
+        int32_t rowSize = table->getRowSize();
+        RowOrder before(table, orderIndex, statement->descending);
+
+        std::vector<char> rows(limit * rowSize);
+        std::vector<int64_t> heap;
+        auto rowAt = [&](int64_t slot){ return rows.data() + slot * rowSize; };
+        auto heapCompare = [&](int64_t a, int64_t b){ return before(rowAt(a), rowAt(b)); };
+
+        TableScan scan(table, std::vector<PredicateKernel>(kernels));
+        while(char* row = scan.next()){
+            if((int64_t)heap.size() < limit){
+                memcpy(rowAt(heap.size()), row, rowSize);
+                heap.push_back(heap.size());
+                std::push_heap(heap.begin(), heap.end(), heapCompare);
+            }
+            else if(before(row, rowAt(heap.front()))){
+                std::pop_heap(heap.begin(), heap.end(), heapCompare);
+                memcpy(rowAt(heap.back()), row, rowSize);
+                std::push_heap(heap.begin(), heap.end(), heapCompare);
+            }
+        }
+
+        std::sort_heap(heap.begin(), heap.end(), heapCompare);
+        for(int64_t slot: heap){
+            if(!emit(rowAt(slot))) break;
+        }
+        return true;
+    }
+
+    template <typename emit_t>
+    static bool memorySort(Table* table, SelectStatement* statement, int32_t orderIndex,
+                           const std::vector<PredicateKernel>& kernels, const emit_t& emit){
+        int32_t rowSize = table->getRowSize();
+        RowOrder before(table, orderIndex, statement->descending);
+        std::vector<char> rows;
+        TableScan scan(table, std::vector<PredicateKernel>(kernels));
+        while(char* row = scan.next()){
+            rows.insert(rows.end(), row, row + rowSize);
+        }
+
+        std::vector<char*> order(rows.size() / rowSize);
+        for(size_t i = 0; i < order.size(); ++i) order[i] = rows.data() + i * rowSize;
+        std::stable_sort(order.begin(), order.end(), before);
+        for(char* row: order){
+            if(!emit(row)) break;
+        }
+        return true;
+    }
+
+    template <typename emit_t>
+    static bool externalSort(Table* table, SelectStatement* statement, int32_t orderIndex,
+                             const std::vector<PredicateKernel>& kernels, const emit_t& emit){
+        TableSort sorter(table, {{orderIndex, statement->descending}});
+        bool res = true;
+        sorter.scan([&](row_t row, const char* key)->bool{
+            char* buffer = fetch(table, row);
+            if(buffer == nullptr){
+                res = false;
+                return false;
+            }
+            if(!matches(buffer, kernels)) return true;
+            return emit(buffer);
+        });
+        return res;
+    }
+};
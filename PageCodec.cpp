@@ -0,0 +1,101 @@
+#include <cstring>
+#include <vector>
+#include "HeaderFiles/PageCodec.h"
+
+// =============================================
+//                  PAGE CODEC
+// =============================================
+
+namespace{
+    inline uint32_t load32(const char* data){
+        uint32_t value;
+        memcpy(&value, data, sizeof(uint32_t));
+        return value;
+    }
+
+    /// Writes extra bytes of a length which didn't fit in its token nibble
+    inline bool putLength(char* out, int32_t& pos, int32_t limit, int32_t length){
+        for(length -= 15; ; length -= 255){
+            if(pos >= limit) return false;
+            out[pos++] = (char)(length >= 255 ? 255 : length);
+            if(length < 255) return true;
+        }
+    }
+
+    inline bool getLength(const char* in, int32_t& pos, int32_t length, int32_t& value){
+        for(;;){
+            if(pos >= length) return false;
+            auto byte = (uint8_t)in[pos++];
+            value += byte;
+            if(byte < 255) return true;
+        }
+    }
+
+    /// Writes literals followed by a match, matchLength 0 for the last sequence
+    bool putSequence(char* out, int32_t& pos, int32_t limit, const char* literals, int32_t numLiterals,
+                     int32_t offset, int32_t matchLength, int32_t minMatch){
+        if(pos >= limit) return false;
+        int32_t token = pos++;
+        int32_t extraMatch = matchLength == 0 ? 0 : matchLength - minMatch;
+        out[token] = (char)(((numLiterals < 15 ? numLiterals : 15) << 4) | (extraMatch < 15 ? extraMatch : 15));
+        if(numLiterals >= 15 && !putLength(out, pos, limit, numLiterals)) return false;
+        if(pos + numLiterals > limit) return false;
+        memcpy(out + pos, literals, numLiterals);
+        pos += numLiterals;
+        if(matchLength == 0) return true;
+
+        if(pos + (int32_t)sizeof(uint16_t) > limit) return false;
+        auto distance = (uint16_t)offset;
+        memcpy(out + pos, &distance, sizeof(uint16_t));
+        pos += sizeof(uint16_t);
+        return extraMatch < 15 || putLength(out, pos, limit, extraMatch);
+    }
+}
+
+int32_t PageCodec::compress(const char* in, int32_t size, char* out, int32_t limit){
+    std::vector<int32_t> table(1 << HASH_BITS, -1);
+    int32_t pos = 0, anchor = 0, length = 0;
+    while(pos + MIN_MATCH <= size){
+        uint32_t sequence = load32(in + pos);
+        uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+        int32_t candidate = table[hash];
+        table[hash] = pos;
+        if(candidate < 0 || pos - candidate > MAX_OFFSET || load32(in + candidate) != sequence){
+            ++pos;
+            continue;
+        }
+        int32_t matchLength = MIN_MATCH;
+        while(pos + matchLength < size && in[candidate + matchLength] == in[pos + matchLength]) ++matchLength;
+        if(!putSequence(out, length, limit, in + anchor, pos - anchor, pos - candidate, matchLength, MIN_MATCH)) return 0;
+        pos += matchLength;
+        anchor = pos;
+    }
+    if(!putSequence(out, length, limit, in + anchor, size - anchor, 0, 0, MIN_MATCH)) return 0;
+    return length;
+}
+
+bool PageCodec::decompress(const char* in, int32_t length, char* out, int32_t size){
+    int32_t pos = 0, written = 0;
+    while(pos < length){
+        auto token = (uint8_t)in[pos++];
+        int32_t numLiterals = token >> 4;
+        if(numLiterals == 15 && !getLength(in, pos, length, numLiterals)) return false;
+        if(pos + numLiterals > length || written + numLiterals > size) return false;
+        memcpy(out + written, in + pos, numLiterals);
+        pos += numLiterals;
+        written += numLiterals;
+        if(pos == length) break;
+
+        if(pos + (int32_t)sizeof(uint16_t) > length) return false;
+        uint16_t offset;
+        memcpy(&offset, in + pos, sizeof(uint16_t));
+        pos += sizeof(uint16_t);
+        int32_t matchLength = token & 15;
+        if(matchLength == 15 && !getLength(in, pos, length, matchLength)) return false;
+        matchLength += MIN_MATCH;
+        if(offset == 0 || offset > written || written + matchLength > size) return false;
+        // Match may overlap bytes it writes e.g. a run of zeros, so it is copied byte by byte
+        for(int32_t i = 0; i < matchLength; ++i, ++written) out[written] = out[written - offset];
+    }
+    return written == size;
+}
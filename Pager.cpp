@@ -1,10 +1,14 @@
 #include "HeaderFiles/Pager.h"
+#include <cstring>
+#include <vector>
 
 template<typename page_t>
 Pager<page_t>::Pager(int pageLimit_): pageLimit(pageLimit_){
     this->fileDescriptor = -1;
     this->fileLength = 0;
     this->maxPages = 0;
+    this->flags = 0;
+    this->pageSize = PAGE_SIZE;
 }
 
 template <typename page_t>
@@ -12,6 +16,8 @@ Pager<page_t>::Pager(const char* fileName, int pageLimit_): pageLimit(pageLimit_
     this->fileDescriptor = -1;
     this->fileLength = 0;
     this->maxPages = 0;
+    this->flags = 0;
+    this->pageSize = PAGE_SIZE;
     if(!this->open(fileName)){
         throw std::runtime_error("Unable to Open Table");
     }
@@ -60,38 +66,36 @@ bool Pager<page_t>::close(){
 /// pageNum is 0 indexed
 template <typename page_t>
 bool Pager<page_t>::getHeader(){
-    header = std::make_unique<page_t>();
-    this->fileLength = static_cast<uint32_t>(lseek(fileDescriptor, 0, SEEK_END));
-    this->maxPages = (this->fileLength + PAGE_SIZE - 1) / PAGE_SIZE;
-    if(maxPages > 0){
-        lseek(fileDescriptor, 0, SEEK_SET);
-        ssize_t bytesRead = ::read(fileDescriptor, header->buffer.get(), PAGE_SIZE);
-        if(bytesRead == -1){
-            printf("Error reading Header: %d\n", errno);
-            return false;
-        }
+    header = newPage();
+    if(getFileLength() == 0) return true;
+    if(!readFrame(0, header->buffer.get())){
+        printf("Error reading Header: %d\n", errno);
+        return false;
+    }
+    // Footer gave a larger page size, header is read again in full
+    if(pageSize != PAGE_SIZE){
+        header = newPage();
+        if(!readFrame(0, header->buffer.get())) return false;
     }
+    this->maxPages = (this->fileLength + getFrameSize() - 1) / getFrameSize();
     return true;
 }
 
 template <typename page_t>
-page_t* Pager<page_t>::read(uint32_t pageNum, std::function<void(page_t*)> callback){
+page_t* Pager<page_t>::read(row_t pageNum, std::function<void(page_t*)> callback){
     if(this->fileDescriptor == -1) return nullptr;
     if(pageNum == 0) return this->header.get();
     std::unique_ptr<page_t> page;
     auto itr = pageMap.find(pageNum);
     if(itr == pageMap.end()){
         // Cache miss. Allocate memory and load from file.
-        page = std::make_unique<page_t>();
+        page = newPage();
         page->pageNum = pageNum;
-        this->fileLength = static_cast<uint32_t>(lseek(fileDescriptor, 0, SEEK_END));
-        this->maxPages = (this->fileLength + PAGE_SIZE - 1) / PAGE_SIZE;
+        this->maxPages = (getFileLength() + getFrameSize() - 1) / getFrameSize();
 
         if(pageNum < maxPages){
             // This page reside in memory so read it
-            lseek(fileDescriptor, pageNum * PAGE_SIZE, SEEK_SET);
-            ssize_t bytesRead = ::read(fileDescriptor, page->buffer.get(), PAGE_SIZE);
-            if(bytesRead == -1){
+            if(!readFrame(pageNum, page->buffer.get())){
                 printf("Error reading file: %d\n", errno);
                 return nullptr;
             }
@@ -119,7 +123,7 @@ page_t* Pager<page_t>::read(uint32_t pageNum, std::function<void(page_t*)> callb
 
 /// This flushes the given page to storage if it is open
 template <typename page_t>
-bool Pager<page_t>::flush(uint32_t pageNum){
+bool Pager<page_t>::flush(row_t pageNum){
     if(this->fileDescriptor == -1) return false;
     if(pageNum == 0){
         return flushPage(header.get());
@@ -137,9 +141,7 @@ template <typename page_t>
 bool Pager<page_t>::flushAll(){
     if(this->fileDescriptor == -1) return false;
     flushPage(header.get());
-    int size = pageQueue.size();
     for(auto& it: pageQueue){
-        int32_t pageNum = it->pageNum;
         if(it->hasUncommitedChanges){
             if(!flushPage(it.get())) return false;
         }
@@ -149,14 +151,156 @@ bool Pager<page_t>::flushAll(){
 
 template <typename page_t>
 bool Pager<page_t>::flushPage(page_t* page){
-    off_t offset = lseek(fileDescriptor, ((page->pageNum) * PAGE_SIZE), SEEK_SET);
-    if (offset == -1) return false;
-    ssize_t bytesWritten = write(fileDescriptor, page->buffer.get(), PAGE_SIZE);
-    if (bytesWritten == -1) return false;
+    if(!writeFrame(page->pageNum, page->buffer.get())) return false;
     page->hasUncommitedChanges = false;
     return true;
 }
 
+template <typename page_t>
+bool Pager<page_t>::readFrame(row_t pageNum, char* buffer){
+    if(pageNum != 0 && (flags & PAGE_COMPRESSION)){
+        int32_t frameSize = getFrameSize();
+        std::vector<char> frame(frameSize, 0);
+        if(pread(fileDescriptor, frame.data(), frameSize, pageNum * frameSize) == -1) return false;
+        if(!decodeFrame(frame.data(), buffer)){
+            errno = EIO;
+            return false;
+        }
+        return true;
+    }
+
+    ssize_t bytesRead = pread(fileDescriptor, buffer, pageSize, pageNum * getFrameSize());
+    if(bytesRead == -1) return false;
+    if(bytesRead < pageSize) memset(buffer + bytesRead, 0, pageSize - bytesRead);
+
+    if(pageNum == 0){
+        const char* footer = buffer + PAGE_SIZE - PAGER_FOOTER_SIZE;
+        uint32_t magic;
+        memcpy(&magic, footer, sizeof(uint32_t));
+        uint32_t version;
+        memcpy(&version, footer + 3 * sizeof(uint32_t), sizeof(uint32_t));
+        if(magic != FILE_MAGIC || version != FORMAT_VERSION) throw std::runtime_error("Unsupported file format version");
+        memcpy(&flags, footer + sizeof(uint32_t), sizeof(uint32_t));
+        memcpy(&pageSize, footer + 2 * sizeof(uint32_t), sizeof(int32_t));
+        if(!isValidPageSize(pageSize)) throw std::runtime_error("Invalid page size in file");
+    }
+    return true;
+}
+
+template <typename page_t>
+bool Pager<page_t>::writeFrame(row_t pageNum, char* buffer){
+    int32_t frameSize = getFrameSize();
+    off_t offset = pageNum * frameSize;
+    if(pageNum == 0){
+        char* footer = buffer + PAGE_SIZE - PAGER_FOOTER_SIZE;
+        memset(footer, 0, PAGER_FOOTER_SIZE);
+        memcpy(footer, &FILE_MAGIC, sizeof(uint32_t));
+        memcpy(footer + sizeof(uint32_t), &flags, sizeof(uint32_t));
+        memcpy(footer + 2 * sizeof(uint32_t), &pageSize, sizeof(int32_t));
+        memcpy(footer + 3 * sizeof(uint32_t), &FORMAT_VERSION, sizeof(uint32_t));
+    }
+    if(pageNum == 0 || !(flags & PAGE_COMPRESSION)){
+        return pwrite(fileDescriptor, buffer, pageSize, offset) == pageSize;
+    }
+
+    // Pages which don't compress are stored as they are, tagged so they are never taken for compressed data
+    std::vector<char> frame(frameSize, 0);
+    uint32_t kind = FRAME_COMPRESSED;
+    int32_t length = PageCodec::compress(buffer, pageSize, frame.data() + FRAME_HEADER_SIZE, pageSize);
+    if(length == 0){
+        kind = FRAME_RAW;
+        length = pageSize;
+        memcpy(frame.data() + FRAME_HEADER_SIZE, buffer, pageSize);
+    }
+    memcpy(frame.data(), &FRAME_MAGIC, sizeof(uint32_t));
+    memcpy(frame.data() + sizeof(uint32_t), &kind, sizeof(uint32_t));
+    memcpy(frame.data() + 2 * sizeof(uint32_t), &length, sizeof(int32_t));
+    int32_t used = FRAME_HEADER_SIZE + length;
+    if(pwrite(fileDescriptor, frame.data(), used, offset) != used) return false;
+    if(used == frameSize) return true;
+
+    // Rest of frame is released, zeros are written where holes can't be punched
+#ifdef FALLOC_FL_PUNCH_HOLE
+    if(fallocate(fileDescriptor, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset + used, frameSize - used) == 0){
+        if(lseek(fileDescriptor, 0, SEEK_END) < offset + frameSize) return ftruncate(fileDescriptor, offset + frameSize) == 0;
+        return true;
+    }
+#endif
+    return pwrite(fileDescriptor, frame.data() + used, frameSize - used, offset + used) == frameSize - used;
+}
+
+template <typename page_t>
+bool Pager<page_t>::decodeFrame(const char* frame, char* buffer) const{
+    uint32_t magic, kind;
+    int32_t length;
+    memcpy(&magic, frame, sizeof(uint32_t));
+    memcpy(&kind, frame + sizeof(uint32_t), sizeof(uint32_t));
+    memcpy(&length, frame + 2 * sizeof(uint32_t), sizeof(int32_t));
+    const char* data = frame + FRAME_HEADER_SIZE;
+
+    // Page past those written, e.g. a hole left by a later page
+    if(magic == 0 && kind == 0 && length == 0){
+        memset(buffer, 0, pageSize);
+        return true;
+    }
+    if(magic != FRAME_MAGIC) return false;
+    if(kind == FRAME_RAW && length == pageSize){
+        memcpy(buffer, data, pageSize);
+        return true;
+    }
+    if(kind == FRAME_COMPRESSED && length > 0 && length <= pageSize){
+        return PageCodec::decompress(data, length, buffer, pageSize);
+    }
+    return false;
+}
+
+template <typename page_t>
+void Pager<page_t>::setPageCompression(bool enabled){
+    uint32_t newFlags = enabled ? (flags | PAGE_COMPRESSION) : (flags & ~PAGE_COMPRESSION);
+    if(newFlags == flags) return;
+    // Frames are larger than pages, so pages already in file would move
+    if(maxPages > 1 || !pageQueue.empty()) throw std::runtime_error("Page compression can't change once file has pages");
+    flags = newFlags;
+    header->hasUncommitedChanges = true;
+}
+
+template <typename page_t>
+bool Pager<page_t>::hasPageCompression() const{
+    return flags & PAGE_COMPRESSION;
+}
+
+template <typename page_t>
+int32_t Pager<page_t>::getFrameSize() const{
+    return (flags & PAGE_COMPRESSION) ? pageSize + FRAME_HEADER_SIZE : pageSize;
+}
+
+template <typename page_t>
+bool Pager<page_t>::isValidPageSize(int32_t size){
+    return size >= PAGE_SIZE && size <= MAX_PAGE_SIZE && (size & (size - 1)) == 0;
+}
+
+template <typename page_t>
+void Pager<page_t>::setPageSize(int32_t size){
+    if(size == pageSize) return;
+    if(!isValidPageSize(size)) throw std::runtime_error("Invalid page size");
+    if(maxPages > 0 || !pageQueue.empty()) throw std::runtime_error("Page size can't change once file has pages");
+    pageSize = size;
+    header = newPage();
+    header->hasUncommitedChanges = true;
+}
+
+template <typename page_t>
+int32_t Pager<page_t>::getPageSize() const{
+    return pageSize;
+}
+
+template <typename page_t>
+std::unique_ptr<page_t> Pager<page_t>::newPage() const{
+    // Nodes of an index always use PAGE_SIZE, see BRANCHING_FACTOR
+    if constexpr(std::is_same_v<page_t, Page>) return std::make_unique<page_t>(pageSize);
+    else return std::make_unique<page_t>();
+}
+
 //void Pager::printQueue(){
 //    for(auto& it: pageQueue){
 //        std::cout << it->pageNum << "->";
@@ -1,3 +1,4 @@
+#include <cctype>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
@@ -18,7 +19,8 @@ enum class StatementType{
     remove,
     create,
     index,
-    drop
+    drop,
+    join
 };
 
 enum class PrepareResult{
@@ -41,7 +43,12 @@ enum class PrepareResult{
 /*
  *  ---------------------- COMMANDS ----------------------
  *  create table <table-name>{<col-1>:<DATATYPE>, <col-2>:<DATATYPE>, ...}
- *  index on {<col-1>, <col-2>} in table
+ *  create table <table-name>{<col-1>:<DATATYPE>, ...} using <LAYOUT>
+ *  create table <table-name>{<col-1>:<DATATYPE>, ...} using clustered on <col-1>
+ *  create table <table-name>{<col-1>:<DATATYPE>, ...} [using <LAYOUT>] with <OPTION>, <OPTION>, ...
+ *  index on {<col-1>} in table
+ *  index on {<col-1>, <col-2>, ...} in table
+ *  index on {<col-1>, ...} include {<col-3>, <col-4>, ...} in table
  *  insert into <table-name>{<col-1-data>, <col-1-data>, ...}
  *  update <table-name> set {<col-1> = <data-1>, <col-1> = <data-1>, ...}
  *  update <table-name> set {<col-1> = <data-1>, <col-1> = <data-1>, ...} where <CONDITION>
@@ -50,6 +57,10 @@ enum class PrepareResult{
  *  drop table <table-name>
  *  select (<col-1>, <col-2>, ...) from <table-name> where <CONDITION>
  *  select * from <table-name> where <CONDITION>
+ *  select (<col-1>, <table>.<col-2>, ...) from <table-1> join <table-2> on <col-1> == <col-2>
+ *  select (<AGGREGATE>, ...) from <table-name> where <CONDITION>
+ *  select (<col-1>, <AGGREGATE>, ...) from <table-name> where <CONDITION> group by <col-1>
+ *  select * from <table-name> where <CONDITION> order by <col-1> [asc|desc] limit <n>
  *
  *  --------------------- DATA TYPES ---------------------
  *  1. string(<length>)
@@ -59,6 +70,20 @@ enum class PrepareResult{
  *  5. bool
  *  6. char
  *
+ *  ---------------------- LAYOUTS ----------------------
+ *  rows        => Fixed width rows (default)
+ *  slotted     => Variable length rows in slotted pages, strings take their actual length
+ *  pax         => Values of each column stored together in a page, scans filter a column
+ *                 without reading the others
+ *  compressed  => Pax with each column of a page dictionary, run length or frame of
+ *                 reference encoded, scans filter encoded values
+ *  clustered   => Rows in leaves of a B+ tree ordered on a unique key column, or on
+ *                 insertion order without one. Key lookups and ranges read no other page
+ *
+ *  ---------------------- OPTIONS ----------------------
+ *  compression         => Pages of table and its indexes are compressed on disk, see Pager
+ *  page size <n>       => Pages of table file are <n> KB, 4, 8, 16, 32 or 64. Indexes keep 4 KB
+ *
  *  --------------------- CONDITION ---------------------
  *  <col-1> == <data-1>
  *  <col-1> != <data-1>
@@ -66,7 +91,22 @@ enum class PrepareResult{
  *  <col-1> < <data-1>
  *  <col-1> <= <data-1>
  *  <col-1> >= <data-1>
- *  <CONDITION> && <CONDITION>
+ *  <CONDITION> && <CONDITION>       (on one column, or on two columns)
+ *
+ *  ---------------------- INDEXES ----------------------
+ *  index on {<col-1>}                  => B+ tree on col-1
+ *  index on {<col-1>, <col-2>, ...}    => Composite index ordered on col-1, then col-2, ... so
+ *                                         <col-1> == <data-1> && <col-2> > <data-2> is one range scan
+ *  include {<col-3>, ...}              => Values of col-3, ... are kept in index, selects reading
+ *                                         only these and key columns read no table page
+ *
+ *  --------------------- AGGREGATE ---------------------
+ *  count(*)
+ *  count(<col>)
+ *  sum(<col>)
+ *  min(<col>)
+ *  max(<col>)
+ *  avg(<col>)
  *
  */
 
@@ -102,9 +142,33 @@ ComparisonType findComparisonType(const char* op){
     return ComparisonType::error;
 }
 
+enum class AggregateType{
+    none,               /// Plain column, must be the group by column
+    count,
+    sum,
+    min,
+    max,
+    avg
+};
+
+AggregateType findAggregateType(const char* func){
+    if(strcmp(func, "count") == 0) return AggregateType::count;
+    if(strcmp(func, "sum") == 0)   return AggregateType::sum;
+    if(strcmp(func, "min") == 0)   return AggregateType::min;
+    if(strcmp(func, "max") == 0)   return AggregateType::max;
+    if(strcmp(func, "avg") == 0)   return AggregateType::avg;
+    return AggregateType::none;
+}
+
+struct Aggregate{
+    AggregateType type = AggregateType::none;
+    std::string col;                /// "*" for count(*)
+};
+
 struct Condition{
     bool isCompound{};
     std::string col;
+    std::string col2;               /// Column of second comparison, same as col unless two columns are compared
     std::string data1;
     std::string data2;
     ComparisonType compType1{};
@@ -121,6 +185,7 @@ struct CreateStatement: public QueryStatement{
     std::vector<std::string> colNames;
     std::vector<DataType> colTypes;
     std::vector<uint32_t> colSize;
+    TableOptions options;
 };
 
 struct InsertStatement: public QueryStatement{
@@ -129,6 +194,7 @@ struct InsertStatement: public QueryStatement{
 
 struct IndexStatement: public QueryStatement{
     std::vector<std::string> colNames;
+    std::vector<std::string> includeNames;      /// Columns stored in leaves of a covering index
 };
 
 struct SelectStatement: public QueryStatement{
@@ -136,6 +202,22 @@ struct SelectStatement: public QueryStatement{
     Condition condition;
     bool selectAllRows{};
     bool selectAllCols{};
+
+    /// One entry per selected column, empty if select has no aggregate and no group by
+    std::vector<Aggregate> aggregates;
+    std::string groupBy;
+
+    std::string orderBy;
+    bool descending{};
+    int64_t limit = -1;             /// -1 when there is no limit
+};
+
+struct JoinStatement: public QueryStatement{
+    std::string rightTableName;
+    std::string leftCol;            /// Join column, may be qualified as <table>.<col>
+    std::string rightCol;
+    std::vector<std::string> colNames;
+    bool selectAllCols{};
 };
 
 struct UpdateStatement: public QueryStatement{
@@ -253,7 +335,7 @@ private:
         // Get Opening quote
         if(sscanf(*ptr, " %1[\"]%n", val, &n) != 1){
             // Value without opening brace
-            sscanf(*ptr, "%255[^,&}) \t\n]s%n", field, &n);
+            sscanf(*ptr, " %255[^,&}) \t\n]%n", field, &n);
             (*ptr) += n;
             return true;
         };
@@ -277,7 +359,7 @@ private:
     }
 
     PrepareResult parseCreate(InputBuffer& inputBuffer){
-        // SYNTAX:- create table <table-name>{<col-1>:<DATATYPE>, <col-2>:<DATATYPE>, ...}
+        // SYNTAX:- create table <table-name>{<col-1>:<DATATYPE>, <col-2>:<DATATYPE>, ...} [using <LAYOUT>]
         this->type = StatementType::create;
         const char *ptr = inputBuffer.str();
         std::vector<std::string> colNames;
@@ -342,7 +424,48 @@ private:
         if(col == 0){
             return PrepareResult::cannotCreateEmptyTable;
         }
+        TableOptions options;
+        char word[20];
+        if(*ptr == '}' && sscanf(ptr + 1, " using %19s%n", word, &n) == 1){
+            if(strcmp(word, "rows") == 0) options.layout = TableLayout::rows;
+            else if(strcmp(word, "slotted") == 0) options.layout = TableLayout::slotted;
+            else if(strcmp(word, "pax") == 0) options.layout = TableLayout::pax;
+            else if(strcmp(word, "compressed") == 0) options.layout = TableLayout::compressed;
+            else if(strcmp(word, "clustered") == 0){
+                // Rows are ordered on pkey unless a key column is named
+                options.layout = TableLayout::clustered;
+                int end = -1;
+                if(sscanf(ptr + 1 + n, " on %49[^ \t\n,]%n", name, &end) == 1){
+                    auto itr = std::find(colNames.begin(), colNames.end(), name);
+                    if(itr == colNames.end()) return PrepareResult::syntaxError;
+                    options.clusterColumn = itr - colNames.begin();
+                    n += end;
+                }
+            }
+            else return PrepareResult::syntaxError;
+            ptr += n;
+        }
+        int start = -1;
+        if(*ptr != '\0') sscanf(ptr + 1, " with %n", &start);
+        for(const char* option = ptr + 1 + start; start >= 0; ){
+            int end = -1, kiloBytes;
+            if(sscanf(option, "compression%n", &end) == 0 && end > 0){
+                options.pageCompression = true;
+            }
+            else if(sscanf(option, "page size %d%n", &kiloBytes, &end) == 1){
+                if(kiloBytes <= 0 || kiloBytes > MAX_PAGE_SIZE / 1024) return PrepareResult::syntaxError;
+                options.pageSize = kiloBytes * 1024;
+                if(!Pager<Page>::isValidPageSize(options.pageSize)) return PrepareResult::syntaxError;
+            }
+            else return PrepareResult::syntaxError;
+            option += end;
+            int next = -1;
+            sscanf(option, " ,%n", &next);
+            if(next < 0) break;
+            option += next + strspn(option + next, " ");
+        }
         auto createStatement = std::make_unique<CreateStatement>();
+        createStatement->options = options;
         createStatement->colNames = std::move(colNames);
         createStatement->colTypes = std::move(colTypes);
         createStatement->colSize  = std::move(colSize);
@@ -351,31 +474,43 @@ private:
     }
 
     PrepareResult parseIndex(InputBuffer& inputBuffer){
-        // SYNTAX:- index on {<col-1>, <col-2>} in table;
+        // SYNTAX:- index on {<col-1>, <col-2>} [include {<col-3>, ...}] in table;
         this->type = StatementType::index;
         const char *ptr = inputBuffer.str() + 8;
-        std::vector<std::string> colNames;
+        std::vector<std::string> colNames, includeNames;
+        if(!parseColumnList(&ptr, colNames)) return PrepareResult::syntaxError;
+        for(auto& colName: colNames) printw("Indexing On: %s\n", colName.c_str());
+
+        // Included columns are stored with keys of index
+        if(strncmp(ptr, "include", 7) == 0){
+            ptr += 7;
+            if(!parseColumnList(&ptr, includeNames)) return PrepareResult::syntaxError;
+        }
+        if(!getTableName(&ptr, "in")) return PrepareResult::noTableName;
+
+        auto indexStatement = std::make_unique<IndexStatement>();
+        indexStatement->colNames = std::move(colNames);
+        indexStatement->includeNames = std::move(includeNames);
+        this->statement = std::move(indexStatement);
+        return PrepareResult::success;
+    }
+
+    /// Reads {<col-1>, <col-2>, ...} and whitespace after it
+    static bool parseColumnList(const char** ptr, std::vector<std::string>& colNames){
         char colName[MAX_COLUMN_SIZE];
         char seperator[3];
-        if(!checkOpeningBrace(&ptr)) return PrepareResult::syntaxError;
+        if(!checkOpeningBrace(ptr)) return false;
         int n = 0;
         while(true){
             // Get String
-            if(sscanf(ptr, "%255[^ \t\n,}]%n", colName, &n) != 1) return PrepareResult::syntaxError;
-            ptr += n;
-            printw("Indexing On: %s\n", colName);
+            if(sscanf(*ptr, "%255[^ \t\n,}]%n", colName, &n) != 1) return false;
+            (*ptr) += n;
             colNames.emplace_back(colName);
-            if(!getSeperator(&ptr, seperator)) return PrepareResult::syntaxError;
+            if(!getSeperator(ptr, seperator)) return false;
             if(seperator[0] == ',') continue;
-            if(seperator[0] == '}') break;
-            else return PrepareResult::syntaxError;
+            if(seperator[0] == '}') return true;
+            return false;
         }
-        if(!getTableName(&ptr, "in")) return PrepareResult::noTableName;
-
-        auto indexStatement = std::make_unique<IndexStatement>();
-        indexStatement->colNames = std::move(colNames);
-        this->statement = std::move(indexStatement);
-        return PrepareResult::success;
     }
 
     PrepareResult parseInsert(InputBuffer& inputBuffer){
@@ -561,6 +696,48 @@ private:
         }
 
         if(!getTableName(&ptr, " from ")) return PrepareResult::noTableName;
+
+        // Trailing clauses are cut off from the end before condition is parsed
+        // Order is: where, group by, order by, limit
+        std::string remaining(ptr);
+        auto pos = findClause(remaining, "limit");
+        if(pos != std::string::npos){
+            long long limit;
+            if(sscanf(remaining.c_str() + pos, "limit %lld %n", &limit, &n) != 1 || remaining[pos + n] != '\0' || limit < 0){
+                return PrepareResult::syntaxError;
+            }
+            selectStatement->limit = limit;
+            remaining.erase(pos);
+        }
+        pos = findClause(remaining, "order by");
+        if(pos != std::string::npos){
+            char orderBy[MAX_FIELD_SIZE + 1];
+            if(sscanf(remaining.c_str() + pos, "order by %255[^ \t\n] %n", orderBy, &n) != 1) return PrepareResult::syntaxError;
+            int m = 0;
+            if(sscanf(remaining.c_str() + pos + n, "%19s %n", keyword, &m) == 1){
+                if(strcmp(keyword, "desc") == 0) selectStatement->descending = true;
+                else if(strcmp(keyword, "asc") != 0) return PrepareResult::syntaxError;
+                n += m;
+            }
+            if(remaining[pos + n] != '\0') return PrepareResult::syntaxError;
+            selectStatement->orderBy = orderBy;
+            remaining.erase(pos);
+        }
+        pos = findClause(remaining, "group by");
+        if(pos != std::string::npos){
+            char groupBy[MAX_FIELD_SIZE + 1];
+            if(sscanf(remaining.c_str() + pos, "group by %255[^ \t\n] %n", groupBy, &n) != 1 ||
+               remaining[pos + n] != '\0'){
+                return PrepareResult::syntaxError;
+            }
+            selectStatement->groupBy = groupBy;
+            remaining.erase(pos);
+        }
+        ptr = remaining.c_str();
+        auto res = parseAggregates(selectStatement);
+        if(res != PrepareResult::success) return res;
+        if(!selectStatement->aggregates.empty() && !selectStatement->orderBy.empty()) return PrepareResult::syntaxError;
+
         if(!parseFormatString(&ptr, keyword, " %20s %n")){
             selectStatement->selectAllRows = true;
         }
@@ -569,6 +746,9 @@ private:
             auto res = parseCondition(ptr, selectStatement->condition);
             if(res != PrepareResult::success) return res;
         }
+        else if(strcmp(keyword, "join") == 0){
+            return parseJoin(ptr, selectStatement);
+        }
         else{
             return PrepareResult::syntaxError;
         }
@@ -577,6 +757,77 @@ private:
         return PrepareResult::success;
     }
 
+    /// Position of last occurrence of clause keyword as a separate word, npos if absent
+    static size_t findClause(const std::string& str, const std::string& clause){
+        size_t pos = str.rfind(clause);
+        while(pos != std::string::npos){
+            size_t end = pos + clause.size();
+            bool startsWord = (pos == 0 || isspace(str[pos - 1]));
+            bool endsWord = (end < str.size() && isspace(str[end]));
+            if(startsWord && endsWord) return pos;
+            if(pos == 0) break;
+            pos = str.rfind(clause, pos - 1);
+        }
+        return std::string::npos;
+    }
+
+    /// Splits selected columns into plain columns and aggregate functions `<func>(<col>)`
+    static PrepareResult parseAggregates(std::unique_ptr<SelectStatement>& selectStatement){
+        std::vector<Aggregate> aggregates;
+        bool hasAggregate = false;
+        char func[10], col[MAX_FIELD_SIZE + 1], closing[2];
+        for(auto& colName: selectStatement->colNames){
+            Aggregate aggregate;
+            if(sscanf(colName.c_str(), "%9[a-z](%255[^)]%1[)]", func, col, closing) == 3){
+                aggregate.type = findAggregateType(func);
+                if(aggregate.type == AggregateType::none) return PrepareResult::syntaxError;
+                if(strcmp(col, "*") == 0 && aggregate.type != AggregateType::count) return PrepareResult::syntaxError;
+                aggregate.col = col;
+                hasAggregate = true;
+            }
+            else{
+                aggregate.col = colName;
+            }
+            aggregates.emplace_back(std::move(aggregate));
+        }
+
+        if(hasAggregate || !selectStatement->groupBy.empty()){
+            if(selectStatement->selectAllCols) return PrepareResult::syntaxError;
+            selectStatement->aggregates = std::move(aggregates);
+        }
+        return PrepareResult::success;
+    }
+
+    PrepareResult parseJoin(const char* ptr, std::unique_ptr<SelectStatement>& selectStatement){
+        // SYNTAX:- select {<col-1>, ...} from <table-1> join <table-2> on <col-1> == <col-2>
+        this->type = StatementType::join;
+        char rightTableName[MAX_TABLE_NAME_LEN];
+        char col1[MAX_FIELD_SIZE + 1], col2[MAX_FIELD_SIZE + 1];
+        char keyword[20];
+        int n = 0;
+
+        if(sscanf(ptr, " %49[^ \t\n] %n", rightTableName, &n) != 1) return PrepareResult::noTableName;
+        ptr += n;
+        if(!parseFormatString(&ptr, keyword, " %19s %n") || strcmp(keyword, "on") != 0){
+            return PrepareResult::syntaxError;
+        }
+        if(sscanf(ptr, " %255[^=!<> \t\n] %2[=!<>] %255[^ \t\n] %n", col1, keyword, col2, &n) != 3){
+            return PrepareResult::syntaxError;
+        }
+        ptr += n;
+        if(strcmp(keyword, "==") != 0) return PrepareResult::invalidOperator;
+        if(*ptr != '\0') return PrepareResult::syntaxError;
+
+        auto joinStatement = std::make_unique<JoinStatement>();
+        joinStatement->rightTableName = rightTableName;
+        joinStatement->leftCol = col1;
+        joinStatement->rightCol = col2;
+        joinStatement->colNames = std::move(selectStatement->colNames);
+        joinStatement->selectAllCols = selectStatement->selectAllCols;
+        this->statement = std::move(joinStatement);
+        return PrepareResult::success;
+    }
+
     static PrepareResult parseCondition(const char* ptr, Condition& cond){
         char col1[255], col2[255];
         char val1[255], val2[255];
@@ -593,13 +844,11 @@ private:
             ptr += n;
             getNextValue(&ptr, val2);
             cond.isCompound = true;
-            if(strcmp(col1, col2) != 0){
-                return PrepareResult::comparisonOnDifferentRows;
-            }
             if(strcmp(combineOperator, "&&") != 0){
                 return PrepareResult::syntaxError;
             }
             cond.col = col1;
+            cond.col2 = col2;
             cond.data1 = val1;
             cond.data2 = val2;
             cond.compType1 = findComparisonType(op1);
@@ -611,6 +860,7 @@ private:
         else if(count <= 0){
             cond.isCompound = false;
             cond.col = col1;
+            cond.col2 = col1;
             cond.data1 = val1;
             cond.compType1 = findComparisonType(op1);
             if(cond.compType1 == ComparisonType::error){
@@ -0,0 +1,52 @@
+#include <cstring>
+#include "HeaderFiles/PaxPage.h"
+
+// =============================================
+//                  PAX PAGE
+// =============================================
+
+PaxPage::PaxPage(const std::vector<uint32_t>& columnSizes, int32_t pageSize){
+    rowSize = 0;
+    for(uint32_t size: columnSizes){
+        fieldOffsets.push_back(rowSize);
+        fieldSizes.push_back(size);
+        rowSize += size;
+    }
+    fieldOffsets.push_back(rowSize);
+    fieldSizes.push_back(sizeof(pkey_t));
+    rowSize += sizeof(pkey_t);
+    numSlots = pageSize / rowSize;
+}
+
+int32_t PaxPage::slotsPerPage() const{
+    return numSlots;
+}
+
+const char* PaxPage::column(const char* page, int32_t index) const{
+    return page + (int64_t)numSlots * fieldOffsets[index];
+}
+
+void PaxPage::expand(const char* page, char* rows) const{
+    for(size_t field = 0; field < fieldSizes.size(); ++field){
+        const char* values = page + (int64_t)numSlots * fieldOffsets[field];
+        char* out = rows + fieldOffsets[field];
+        const uint32_t size = fieldSizes[field];
+        for(int32_t slot = 0; slot < numSlots; ++slot){
+            memcpy(out + (int64_t)slot * rowSize, values + (int64_t)slot * size, size);
+        }
+    }
+}
+
+void PaxPage::write(char* page, int32_t slot, const char* row) const{
+    for(size_t field = 0; field < fieldSizes.size(); ++field){
+        char* values = page + (int64_t)numSlots * fieldOffsets[field];
+        memcpy(values + (int64_t)slot * fieldSizes[field], row + fieldOffsets[field], fieldSizes[field]);
+    }
+}
+
+void PaxPage::read(const char* page, int32_t slot, char* row) const{
+    for(size_t field = 0; field < fieldSizes.size(); ++field){
+        const char* values = page + (int64_t)numSlots * fieldOffsets[field];
+        memcpy(row + fieldOffsets[field], values + (int64_t)slot * fieldSizes[field], fieldSizes[field]);
+    }
+}
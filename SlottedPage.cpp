@@ -0,0 +1,171 @@
+#include <cstring>
+#include <algorithm>
+#include "HeaderFiles/SlottedPage.h"
+
+// =============================================
+//                  SLOTTED PAGE
+// =============================================
+
+namespace{
+    struct Slot{
+        uint16_t offset;
+        uint16_t length;
+    };
+
+    inline Slot* slotAt(char* page, int32_t slot){
+        return reinterpret_cast<Slot*>(page + 2 * sizeof(int32_t)) + slot;
+    }
+
+    inline const Slot* slotAt(const char* page, int32_t slot){
+        return reinterpret_cast<const Slot*>(page + 2 * sizeof(int32_t)) + slot;
+    }
+
+    inline int32_t dataStart(const char* page, int32_t pageSize){
+        int32_t start;
+        memcpy(&start, page, sizeof(int32_t));
+        return start == 0 ? pageSize : start;
+    }
+
+    inline int32_t usedBytes(const char* page){
+        int32_t used;
+        memcpy(&used, page + sizeof(int32_t), sizeof(int32_t));
+        return used;
+    }
+
+    inline void setDataStart(char* page, int32_t start){
+        memcpy(page, &start, sizeof(int32_t));
+    }
+
+    inline void setUsedBytes(char* page, int32_t used){
+        memcpy(page + sizeof(int32_t), &used, sizeof(int32_t));
+    }
+}
+
+SlottedPage::SlottedPage(const std::vector<DataType>& columnTypes_, const std::vector<uint32_t>& columnSizes_, int32_t pageSize_){
+    pageSize = pageSize_;
+    columnTypes = columnTypes_;
+    columnSizes = columnSizes_;
+    rowSize = sizeof(pkey_t);
+    int32_t minEncodedSize = sizeof(pkey_t);
+    for(size_t i = 0; i < columnSizes.size(); ++i){
+        rowSize += columnSizes[i];
+        minEncodedSize += (columnTypes[i] == DataType::String) ? sizeof(uint16_t) : columnSizes[i];
+    }
+    maxEncodedSize = minEncodedSize;
+    for(size_t i = 0; i < columnSizes.size(); ++i){
+        if(columnTypes[i] == DataType::String) maxEncodedSize += columnSizes[i];
+    }
+
+    // Enough slots for a page of shortest rows, but a longest row must still fit in an empty page
+    numSlots = (pageSize - HEADER_SIZE) / (minEncodedSize + SLOT_SIZE);
+    numSlots = std::min(numSlots, (pageSize - HEADER_SIZE - maxEncodedSize) / SLOT_SIZE);
+    numSlots = std::max(numSlots, 1);
+}
+
+int32_t SlottedPage::slotsPerPage() const{
+    return numSlots;
+}
+
+int32_t SlottedPage::encode(const char* row, char* out) const{
+    int32_t length = 0;
+    for(size_t i = 0; i < columnSizes.size(); ++i){
+        if(columnTypes[i] == DataType::String){
+            auto size = (uint16_t)strnlen(row, columnSizes[i]);
+            memcpy(out + length, &size, sizeof(uint16_t));
+            memcpy(out + length + sizeof(uint16_t), row, size);
+            length += sizeof(uint16_t) + size;
+        }
+        else{
+            memcpy(out + length, row, columnSizes[i]);
+            length += columnSizes[i];
+        }
+        row += columnSizes[i];
+    }
+    memcpy(out + length, row, sizeof(pkey_t));
+    return length + sizeof(pkey_t);
+}
+
+void SlottedPage::decode(const char* in, char* row) const{
+    for(size_t i = 0; i < columnSizes.size(); ++i){
+        if(columnTypes[i] == DataType::String){
+            uint16_t size;
+            memcpy(&size, in, sizeof(uint16_t));
+            memcpy(row, in + sizeof(uint16_t), size);
+            memset(row + size, 0, columnSizes[i] - size);
+            in += sizeof(uint16_t) + size;
+        }
+        else{
+            memcpy(row, in, columnSizes[i]);
+            in += columnSizes[i];
+        }
+        row += columnSizes[i];
+    }
+    memcpy(row, in, sizeof(pkey_t));
+}
+
+/// Moves live rows to end of page so that all free space is between directory and rows
+void SlottedPage::compact(char* page) const{
+    std::vector<char> rows(pageSize);
+    int32_t end = pageSize;
+    for(int32_t i = 0; i < numSlots; ++i){
+        Slot* slot = slotAt(page, i);
+        if(slot->length == 0) continue;
+        end -= slot->length;
+        memcpy(rows.data() + end, page + slot->offset, slot->length);
+        slot->offset = end;
+    }
+    memcpy(page + end, rows.data() + end, pageSize - end);
+    setDataStart(page, end);
+}
+
+bool SlottedPage::hasRoom(const char* page) const{
+    return pageSize - HEADER_SIZE - numSlots * SLOT_SIZE - usedBytes(page) >= maxEncodedSize;
+}
+
+void SlottedPage::expand(const char* page, char* rows) const{
+    for(int32_t i = 0; i < numSlots; ++i){
+        if(!read(page, i, rows + (int64_t)i * rowSize)) memset(rows + (int64_t)i * rowSize, 0, rowSize);
+    }
+}
+
+bool SlottedPage::write(char* page, int32_t slotNum, const char* row) const{
+    std::vector<char> encoded(maxEncodedSize);
+    int32_t length = encode(row, encoded.data());
+    Slot* slot = slotAt(page, slotNum);
+    int32_t used = usedBytes(page);
+
+    // Row which doesn't grow is rewritten in place
+    if(slot->length >= length){
+        memcpy(page + slot->offset, encoded.data(), length);
+        setUsedBytes(page, used - slot->length + length);
+        slot->length = length;
+        return true;
+    }
+
+    int32_t directoryEnd = HEADER_SIZE + numSlots * SLOT_SIZE;
+    used -= slot->length;
+    if(pageSize - directoryEnd - used < length) return false;
+    slot->length = 0;
+    if(dataStart(page, pageSize) - directoryEnd < length) compact(page);
+
+    int32_t start = dataStart(page, pageSize) - length;
+    memcpy(page + start, encoded.data(), length);
+    slot->offset = start;
+    slot->length = length;
+    setDataStart(page, start);
+    setUsedBytes(page, used + length);
+    return true;
+}
+
+bool SlottedPage::read(const char* page, int32_t slotNum, char* row) const{
+    const Slot* slot = slotAt(page, slotNum);
+    if(slot->length == 0) return false;
+    decode(page + slot->offset, row);
+    return true;
+}
+
+void SlottedPage::erase(char* page, int32_t slotNum) const{
+    Slot* slot = slotAt(page, slotNum);
+    setUsedBytes(page, usedBytes(page) - slot->length);
+    slot->length = 0;
+}
@@ -0,0 +1,107 @@
+#include <cstring>
+#include <limits>
+#include "HeaderFiles/SortKey.h"
+
+// =============================================
+//                  SORT KEY
+// =============================================
+
+namespace{
+    /// Writes value of size bytes in big endian order
+    inline void writeBigEndian(uint32_t value, int32_t size, char* dest){
+        for(int32_t i = size - 1; i >= 0; --i){
+            dest[i] = (char)(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    inline uint32_t readBigEndian(const char* src, int32_t size){
+        uint32_t value = 0;
+        for(int32_t i = 0; i < size; ++i) value = (value << 8) | (uint8_t)src[i];
+        return value;
+    }
+}
+
+SortKey::SortKey(std::vector<SortColumn> columns_): columns(std::move(columns_)){
+    width = 0;
+    for(auto& column: columns) width += column.size;
+}
+
+void SortKey::encode(const char* row, char* key) const{
+    for(size_t i = 0; i < columns.size(); ++i){
+        encodeValue(i, row + columns[i].offset, key);
+        key += columns[i].size;
+    }
+}
+
+void SortKey::encodeValue(size_t index, const char* data, char* key) const{
+    const SortColumn& column = columns[index];
+    switch(column.type){
+        case DataType::Int: {
+            uint32_t bits;
+            memcpy(&bits, data, sizeof(uint32_t));
+            writeBigEndian(bits ^ 0x80000000u, sizeof(uint32_t), key);
+            break;
+        }
+        case DataType::Float: {
+            uint32_t bits;
+            memcpy(&bits, data, sizeof(uint32_t));
+            bits = (bits & 0x80000000u) ? ~bits : (bits ^ 0x80000000u);
+            writeBigEndian(bits, sizeof(uint32_t), key);
+            break;
+        }
+        case DataType::Char:
+            key[0] = std::numeric_limits<char>::is_signed ? (char)(data[0] ^ 0x80) : data[0];
+            break;
+        case DataType::Bool:
+            key[0] = data[0];
+            break;
+        case DataType::String: {
+            size_t len = strnlen(data, column.size);
+            memcpy(key, data, len);
+            memset(key + len, 0, column.size - len);
+            break;
+        }
+    }
+    if(column.descending){
+        for(int32_t i = 0; i < column.size; ++i) key[i] = ~key[i];
+    }
+}
+
+std::vector<std::string> SortKey::decode(const char* key) const{
+    std::vector<std::string> values;
+    std::string buffer;
+    for(auto& column: columns){
+        buffer.assign(key, column.size);
+        if(column.descending){
+            for(auto& c: buffer) c = ~c;
+        }
+        const char* data = buffer.data();
+        switch(column.type){
+            case DataType::Int: {
+                int32_t value = (int32_t)(readBigEndian(data, sizeof(uint32_t)) ^ 0x80000000u);
+                values.emplace_back(std::to_string(value));
+                break;
+            }
+            case DataType::Float: {
+                uint32_t bits = readBigEndian(data, sizeof(uint32_t));
+                bits = (bits & 0x80000000u) ? (bits ^ 0x80000000u) : ~bits;
+                float value;
+                memcpy(&value, &bits, sizeof(float));
+                values.emplace_back(std::to_string(value));
+                break;
+            }
+            case DataType::Char:
+                values.emplace_back(1, std::numeric_limits<char>::is_signed ? (char)(data[0] ^ 0x80) : data[0]);
+                break;
+            case DataType::Bool:
+                values.emplace_back(data[0] ? "true" : "false");
+                break;
+            case DataType::String:
+                values.emplace_back(data, strnlen(data, column.size));
+                break;
+        }
+        key += column.size;
+    }
+    return values;
+}
@@ -1,9 +1,19 @@
+#include <algorithm>
+#include <filesystem>
 #include "HeaderFiles/Table.h"
 
 // =============================================
 //                  TABLE
 // =============================================
 
+namespace{
+    // Header page trailer, just before footer of Pager
+    const int32_t LAYOUT_OFFSET = PAGE_SIZE - PAGER_FOOTER_SIZE - sizeof(int32_t);
+    const int32_t FIRST_PAGE_WITH_ROOM_OFFSET = LAYOUT_OFFSET - sizeof(row_t);
+    const int32_t CLUSTER_COLUMN_OFFSET = FIRST_PAGE_WITH_ROOM_OFFSET - sizeof(int32_t);
+    const int32_t CLUSTER_ROOT_OFFSET = CLUSTER_COLUMN_OFFSET - sizeof(row_t);
+}
+
 Table::Table(std::string tableName, const std::string& fileName){
     try{
         this->pager = std::make_unique<Pager<Page>>(fileName.c_str());
@@ -16,17 +26,22 @@ Table::Table(std::string tableName, const std::string& fileName){
     // 1. Column Names
     // 2. Column Types
     // 3. Column Size
-    // 4. Empty Rows
     this->tableOpen = true;
     this->tableName = std::move(tableName);
+    this->fileName = fileName;
     this->numRows = 0;
     this->rowSize = 0;
     this->rowsPerPage = 0;
-    // this->rowStackPtr = 0;
-    // this->rowStackOffset = 0;
-    this->rowStack = nullptr;
-    this->stackSize = 0;
+    this->freeMap = std::make_unique<FreeSpaceMap>(
+            std::filesystem::path(fileName).replace_extension(".fsm").string());
+    this->layout = TableLayout::rows;
+    this->firstPageWithRoom = 0;
+    this->clusterColumn = -1;
+    this->clusterRoot = 0;
+    this->leafRowsOffset = 0;
     this->nextPKey = 1;
+    this->tableIsIndexed = false;
+    this->anyIndex = -1;
 }
 
 Table::~Table(){
@@ -34,25 +49,41 @@ Table::~Table(){
 }
 
 bool Table::close(){
-    if(tableOpen) return pager->close();
-    return false;
+    if(!tableOpen) return false;
+    freeMap->close();
+    for(auto& covering: coveringIndexes){
+        if(covering != nullptr) covering->close();
+    }
+    return pager->close();
+}
+
+bool Table::flushAll(){
+    for(auto& covering: coveringIndexes){
+        if(covering != nullptr && !covering->flushAll()) return false;
+    }
+    return freeMap->flushAll() && pager->flushAll();
 }
 
 Cursor Table::start(){
     Cursor cursor(this);
     cursor.row = 0;
-    cursor.endOfTable = (numRows == 0);
+    cursor.endOfTable = (numSlots() == 0);
     return cursor;
 }
 
 Cursor Table::end(){
     Cursor cursor(this);
-    cursor.row = numRows;
+    cursor.row = numSlots();
     cursor.endOfTable = true;
     return cursor;
 }
 
-void Table::createColumns(std::vector<std::string>&& columnNames_, std::vector<DataType>&& columnTypes_, std::vector<uint32_t>&& columnSizes_){
+void Table::createColumns(std::vector<std::string>&& columnNames_, std::vector<DataType>&& columnTypes_, std::vector<uint32_t>&& columnSizes_,
+                          const TableOptions& options){
+    this->layout = options.layout;
+    this->clusterColumn = options.clusterColumn;
+    this->pager->setPageSize(options.pageSize);
+    this->pager->setPageCompression(options.pageCompression);
     this->columnNames = std::move(columnNames_);
     this->columnSizes = std::move(columnSizes_);
     this->columnTypes = std::move(columnTypes_);
@@ -79,6 +110,7 @@ void Table::storeMetadata() {
 
     trees.reserve(columnNames.size());
     for(int i = 0; i < columnNames.size(); ++i) trees.emplace_back(nullptr);
+    coveringIndexes.resize(columnNames.size());
 }
 
 void Table::loadMetadata() {
@@ -89,15 +121,41 @@ void Table::loadMetadata() {
 
     trees.reserve(columnNames.size());
     for(int i = 0; i < columnNames.size(); ++i) trees.emplace_back(nullptr);
+    coveringIndexes.resize(columnNames.size());
 }
 
 void Table::calculateRowInfo(){
     this->rowSize = 0;
+    this->columnOffsets.clear();
     for(int32_t size: columnSizes){
+        this->columnOffsets.push_back(this->rowSize);
         this->rowSize += size;
     }
     this->rowSize += sizeof(pkey_t);
-    this->rowsPerPage = PAGE_SIZE/rowSize;
+    int32_t pageSize = pager->getPageSize();
+    this->rowsPerPage = pageSize/rowSize;
+    if(layout == TableLayout::slotted){
+        this->slotted = std::make_unique<SlottedPage>(columnTypes, columnSizes, pageSize);
+        this->rowsPerPage = slotted->slotsPerPage();
+    }
+    if(layout == TableLayout::pax) this->pax = std::make_unique<PaxPage>(columnSizes, pageSize);
+    if(layout == TableLayout::compressed){
+        this->compressed = std::make_unique<CompressedPage>(columnTypes, columnSizes, pageSize);
+        this->rowsPerPage = compressed->slotsPerPage();
+    }
+    if(layout == TableLayout::clustered){
+        // Keyed on cluster column, or on pkey if table has none
+        RecordFormat format;
+        format.recordSize = rowSize;
+        if(clusterColumn != -1){
+            format.keyColumns.push_back({columnTypes[clusterColumn], (int32_t)columnOffsets[clusterColumn], (int32_t)columnSizes[clusterColumn]});
+        }
+        else format.pkeyOffset = rowSize - sizeof(pkey_t);
+        this->rowsPerPage = ClusteredTree::slotsPerPage(pageSize, rowSize);
+        this->leafRowsOffset = ClusteredTree::recordsOffset(pageSize, rowSize);
+        row_t numPages = rowsPerPage > 0 ? numSlots() / rowsPerPage : 0;
+        this->clustered = std::make_unique<ClusteredTree>(pager.get(), freeMap.get(), std::move(format), clusterRoot, numPages);
+    }
     int32_t count = columnSizes.size();
     this->indexed.assign(count, false);
     this->stackPtr.assign(count, 0);
@@ -144,12 +202,13 @@ void Table::serailizeColumnMetadata(char* buffer){
         offset += sizeof(DataType);
     }
 
-    // int32_t rowStackPtr = 0;
-    // memcpy(buffer + offset, &rowStackPtr, sizeof(int32_t));
-    stackSize = (PAGE_SIZE - offset)/sizeof(row_t);
-    rowStack = new(buffer + offset) row_t[stackSize];
-    rowStack[0] = 0;
-    // rowStackOffset = offset + sizeof(int32_t);
+    // Page trailer, zero in older files i.e. rows layout
+    this->firstPageWithRoom = 0;
+    memcpy(buffer + FIRST_PAGE_WITH_ROOM_OFFSET, &firstPageWithRoom, sizeof(row_t));
+    memcpy(buffer + LAYOUT_OFFSET, &layout, sizeof(TableLayout));
+    this->clusterRoot = 0;
+    memcpy(buffer + CLUSTER_COLUMN_OFFSET, &clusterColumn, sizeof(int32_t));
+    memcpy(buffer + CLUSTER_ROOT_OFFSET, &clusterRoot, sizeof(row_t));
 }
 
 void Table::deSerailizeColumnMetadata(char* metadataBuffer) {
@@ -188,45 +247,142 @@ void Table::deSerailizeColumnMetadata(char* metadataBuffer) {
         offset += sizeof(DataType);
     }
 
-    // memcpy(&stackIndex, (metadataBuffer + offset), sizeof(int32_t));
-    // stackIndex = new(metadataBuffer + offset) int32_t;
-    // offset += sizeof(int32_t);
-    // int32_t rowStackOffset = offset + sizeof(int32_t);
-    stackSize = (PAGE_SIZE - offset)/sizeof(row_t);
-    rowStack = new(metadataBuffer + offset) row_t[stackSize];
+    memcpy(&firstPageWithRoom, metadataBuffer + FIRST_PAGE_WITH_ROOM_OFFSET, sizeof(row_t));
+    memcpy(&layout, metadataBuffer + LAYOUT_OFFSET, sizeof(TableLayout));
+    if(layout == TableLayout::clustered){
+        memcpy(&clusterColumn, metadataBuffer + CLUSTER_COLUMN_OFFSET, sizeof(int32_t));
+        memcpy(&clusterRoot, metadataBuffer + CLUSTER_ROOT_OFFSET, sizeof(row_t));
+    }
 }
 
 row_t Table::nextFreeRowLocation(){
-    if(rowStack[0] == 0) return numRows;
-    row_t nextRow = rowStack[rowStack[0]];
-    rowStack[0]--;
-    pager->header->hasUncommitedChanges = true;
-    // char* buffer = page->buffer.get();
-    // int32_t offset = (stackIndex - 1) * sizeof(row_t) + rowStackOffset;
-    // memcpy(&nextRow, buffer + offset, sizeof(row_t));
-    // memcpy(buffer, &stackIndex, sizeof(int32_t));
-    return nextRow;
+    if(layout == TableLayout::slotted) return nextSlottedLocation();
+    row_t nextRow = freeMap->take();
+    return nextRow == -1 ? numRows : nextRow;
 }
 
-void Table::addFreeRowLocation(row_t location){
-    ++rowStack[0];
-    if(rowStack[0] >= stackSize){
-        printf("Stack Overflow occurred in main table.\n");
-        throw std::runtime_error("STACK OVERFLOWS HEADER PAGE");
+/// Free slot on lowest page which can take any row
+/// Pages found full are skipped as a whole and firstPageWithRoom moves past them
+row_t Table::nextSlottedLocation(){
+    row_t row = freeMap->next(firstPageWithRoom * rowsPerPage);
+    while(row != -1){
+        row_t pageIndex = row / rowsPerPage;
+        Page* page = pager->read(pageIndex + 1);
+        if(page == nullptr) throw std::runtime_error("Error reading table page");
+        if(slotted->hasRoom(page->buffer.get())){
+            freeMap->remove(row);
+            setFirstPageWithRoom(pageIndex);
+            return row;
+        }
+        row = freeMap->next((pageIndex + 1) * rowsPerPage);
     }
-    rowStack[rowStack[0]] = location;
+
+    // Every page is full. Row goes to first slot of a new page, its other slots are free
+    row_t first = numSlots();
+    for(row_t slot = first + 1; slot < first + rowsPerPage; ++slot) freeMap->add(slot);
+    setFirstPageWithRoom(first / rowsPerPage);
+    return first;
+}
+
+void Table::setFirstPageWithRoom(row_t page){
+    if(page == firstPageWithRoom) return;
+    firstPageWithRoom = page;
+    memcpy(pager->header->buffer.get() + FIRST_PAGE_WITH_ROOM_OFFSET, &firstPageWithRoom, sizeof(row_t));
     pager->header->hasUncommitedChanges = true;
-    // Page* page = pager->header.get();
-    // char* buffer = page->buffer.get();
-    // int32_t offset = rowStackPtr * sizeof(row_t) + sizeof(int32_t);
-    // rowStackPtr++;
-    // memcpy(buffer + offset, &location, sizeof(row_t));
+}
+
+void Table::setClusterRoot(row_t root){
+    if(root == clusterRoot) return;
+    clusterRoot = root;
+    memcpy(pager->header->buffer.get() + CLUSTER_ROOT_OFFSET, &clusterRoot, sizeof(row_t));
+    pager->header->hasUncommitedChanges = true;
+}
+
+void Table::addFreeRowLocation(row_t location){
+    freeMap->add(location);
+}
+
+const std::string& Table::getTableName() const{
+    return this->tableName;
+}
+
+/// Path of file holding header page and rows
+const std::string& Table::getFileName() const{
+    return this->fileName;
 }
 
 int32_t Table::getRowSize() const{
     return this->rowSize;
 }
 
+int32_t Table::getRowsPerPage() const{
+    return this->rowsPerPage;
+}
+
+TableLayout Table::getLayout() const{
+    return this->layout;
+}
+
+/// Column ordering rows of a clustered table, -1 if they are ordered on pkey
+int32_t Table::getClusterColumn() const{
+    return this->clusterColumn;
+}
+
+/// Decodes a slotted, pax or compressed data page into rowsPerPage fixed width rows
+void Table::expandPage(const char* page, char* rows) const{
+    if(layout == TableLayout::clustered) memcpy(rows, page + leafRowsOffset, (int64_t)rowsPerPage * rowSize);
+    else if(layout == TableLayout::slotted) slotted->expand(page, rows);
+    else if(layout == TableLayout::pax) pax->expand(page, rows);
+    else if(layout == TableLayout::compressed) compressed->expand(page, rows);
+    else memcpy(rows, page, (int64_t)rowsPerPage * rowSize);
+}
+
+/// Fixed width rows of a data page, rowsPerPage rows rowSize bytes apart
+/// Rows and clustered leaves are used in place, other layouts are decoded into page->image when first accessed
+char* Table::pageRows(Page* page){
+    if(layout == TableLayout::rows) return page->buffer.get();
+    if(layout == TableLayout::clustered) return page->buffer.get() + leafRowsOffset;
+    if(page->image == nullptr){
+        page->image = std::make_unique<char[]>((int64_t)rowsPerPage * rowSize);
+        expandPage(page->buffer.get(), page->image.get());
+    }
+    return page->image.get();
+}
+
+/// Encodes row changed through pageRows into its page, a compressed page is encoded again as a whole
+/// If it doesn't fit a slotted page anymore image is restored from page and false is returned
+bool Table::storeRow(Page* page, row_t row){
+    page->hasUncommitedChanges = true;
+    if(layout == TableLayout::rows || layout == TableLayout::clustered) return true;
+    int32_t slot = row % rowsPerPage;
+    char* image = pageRows(page) + (int64_t)slot * rowSize;
+    if(layout == TableLayout::pax){
+        pax->write(page->buffer.get(), slot, image);
+        return true;
+    }
+    if(layout == TableLayout::compressed){
+        compressed->compress(pageRows(page), page->buffer.get());
+        return true;
+    }
+    if(slotted->write(page->buffer.get(), slot, image)) return true;
+    if(!slotted->read(page->buffer.get(), slot, image)) memset(image, 0, rowSize);
+    return false;
+}
+
+row_t Table::getNumRows() const{
+    return this->numRows;
+}
+
+/// Number of row slots written to file, deleted rows included
+row_t Table::numSlots() const{
+    return this->numRows + freeMap->count();
+}
+
+/// Deleted row slots in ascending order
+std::vector<row_t> Table::freeRowLocations() const{
+    return freeMap->locations();
+}
+
 void Table::increaseRowCount() {
     this->numRows++;
     this->nextPKey++;
@@ -258,11 +414,37 @@ bool Table::createIndex(int index, const std::string& filename){
             trees[index] = std::make_unique<BPTree<dbms::string>>(filename.c_str(), branchingFactor, columnSizes[index]);
             break;
     }
+    // Indexes of a table with compressed pages are compressed too
+    if(pager->hasPageCompression()) trees[index]->setPageCompression(true);
     anyIndex = index;
     tableIsIndexed = true;
     return true;
 }
 
+/// Covering index keyed on keyColumns with values of included columns, file is read if it exists
+/// It is found through its first key column
+bool Table::createCoveringIndex(std::vector<int32_t> keyColumns, std::vector<int32_t> included, const std::string& filename){
+    int32_t column = keyColumns[0];
+    try{
+        coveringIndexes[column] = std::make_unique<CoveringIndex>(filename, std::move(keyColumns), std::move(included),
+                                                                  columnTypes, columnSizes);
+    }
+    catch(...){
+        coveringIndexes[column].reset();
+        return false;
+    }
+    if(pager->hasPageCompression()) coveringIndexes[column]->setPageCompression(true);
+    return true;
+}
+
+/// Inserts row into a leaf of clustered tree in key order, root is stored if it split
+/// Returns row number, -1 if a row with same key is in table
+row_t Table::insertClustered(const char* row){
+    row_t location = clustered->insert(row);
+    setClusterRoot(clustered->getRoot());
+    return location;
+}
+
 bool Table::insertBTree(std::vector<std::string>& data, row_t row){
     for(int i = 0; i < indexed.size(); ++i){
         if(!indexed[i]) continue;
@@ -272,17 +454,73 @@ bool Table::insertBTree(std::vector<std::string>& data, row_t row){
         }
         if(!res) return false;
     }
+
+    // Covering indexes store raw values, row is read back from its page
+    Cursor cursor(this);
+    for(auto& covering: coveringIndexes){
+        if(covering == nullptr) continue;
+        cursor.row = row;
+        char* buffer = cursor.value();
+        if(buffer == nullptr || !covering->insert(buffer, row)) return false;
+    }
+    return true;
+}
+
+bool Table::updateCovering(const char* oldImage, row_t oldRow, const char* newImage, row_t newRow){
+    for(auto& covering: coveringIndexes){
+        if(covering != nullptr && !covering->update(oldImage, oldRow, newImage, newRow)) return false;
+    }
     return true;
 }
 
 bool Table::deleteRow(row_t row){
+    Cursor cursor(this);
+    for(auto& covering: coveringIndexes){
+        if(covering == nullptr) continue;
+        cursor.row = row;
+        char* buffer = cursor.value();
+        if(buffer == nullptr || !covering->remove(buffer)) return false;
+    }
     this->numRows--;
     Page* page = pager->header.get();
     char* buffer = page->buffer.get();
     memcpy(buffer, &numRows, sizeof(row_t));
     page->hasUncommitedChanges = true;
+    return freeSlot(row);
+}
+
+/// Moves a row which grew too large for its slotted page to a page with room
+/// Returns new row number or -1, number of rows is unchanged
+row_t Table::relocateRow(row_t row, const char* image){
+    Cursor cursor(this);
+    cursor.row = nextFreeRowLocation();
+    char* buffer = cursor.value();
+    if(buffer == nullptr) return -1;
+    memcpy(buffer, image, rowSize);
+    if(!cursor.addedChangesToCommit() || !freeSlot(row)) return -1;
+    return cursor.row;
+}
+
+bool Table::freeSlot(row_t row){
+    if(layout == TableLayout::slotted){
+        row_t pageIndex = row / rowsPerPage;
+        Page* page = pager->read(pageIndex + 1);
+        if(page == nullptr) return false;
+        slotted->erase(page->buffer.get(), row % rowsPerPage);
+        page->hasUncommitedChanges = true;
+        if(pageIndex < firstPageWithRoom) setFirstPageWithRoom(pageIndex);
+    }
+    if(layout == TableLayout::clustered) clustered->erase(row);
     addFreeRowLocation(row);
     return true;
 }
 
+/// Index on column, for cluster column the clustered tree itself. nullptr if column has none
+BPlusTreeBase* Table::index(int32_t column) const{
+    if(clustered != nullptr && column == clusterColumn) return clustered.get();
+    return indexed[column] ? trees[column].get() : nullptr;
+}
 
+CoveringIndex* Table::coveringIndex(int32_t column) const{
+    return coveringIndexes[column].get();
+}
@@ -31,7 +31,8 @@ TableManager::TableManager(std::string baseURL_):baseURL(std::move(baseURL_)){
 void TableManager::loadIndexes(const std::shared_ptr<Table>& table){
     std::string indexURL = baseURL + "/indexes";
     for (auto& itr: std::filesystem::directory_iterator(indexURL)){
-        if(itr.is_regular_file()){
+        bool covering = itr.path().extension() == ".cov";
+        if(itr.is_regular_file() && (itr.path().extension() == ".idx" || covering)){
             std::string indexFileName = itr.path().stem().string();
             int i = (int)indexFileName.size() - 1;
             while(i >= 0 && indexFileName[i] != '_') --i;
@@ -39,7 +40,12 @@ void TableManager::loadIndexes(const std::shared_ptr<Table>& table){
             if(table->tableName != foundTableName) continue;
             try{
                 int32_t colNum = std::stoi(indexFileName.substr(i+1, indexFileName.size()));
-                if(colNum < table->columnSizes.size()){
+                if(covering && colNum < table->columnSizes.size()){
+                    if(table->createCoveringIndex({colNum}, {}, itr.path().string())){
+                        printw("Found Covering Indexfile on column %d\n", colNum + 1);
+                    }
+                }
+                else if(colNum < table->columnSizes.size()){
                     table->indexed[colNum] = true;
                     table->createIndex(colNum, itr.path().string());
                     printw("Found Indexfile on column %d\n", colNum + 1);
@@ -78,7 +84,8 @@ TableManagerResult TableManager::open(const std::string& tableName, std::shared_
 TableManagerResult TableManager::create(const std::string& tableName,
                                         std::vector<std::string>&& columnNames_,
                                         std::vector<DataType>&& columnTypes_,
-                                        std::vector<uint32_t>&& columnSize_){
+                                        std::vector<uint32_t>&& columnSize_,
+                                        const TableOptions& options){
     if(tableMap.find(tableName) != tableMap.end()){
         return TableManagerResult::tableAlreadyExists;
     }
@@ -91,8 +98,16 @@ TableManagerResult TableManager::create(const std::string& tableName,
     }
 
     // Store metadata in first page
-    table->createColumns(std::move(columnNames_), std::move(columnTypes_), std::move(columnSize_));
-    table->storeMetadata();
+    // Fails if rows don't fit pages of the layout e.g. two rows in a clustered leaf
+    try{
+        table->createColumns(std::move(columnNames_), std::move(columnTypes_), std::move(columnSize_), options);
+        table->storeMetadata();
+    }catch(...){
+        table->close();
+        std::remove(getFileName(tableName, TableFileType::baseTable).c_str());
+        std::remove(getFileName(tableName, TableFileType::freeSpaceMap).c_str());
+        return TableManagerResult::tableCreationFaliure;
+    }
     tableMap[tableName] = table;
     return TableManagerResult::tableCreatedSuccessfully;
 }
@@ -107,6 +122,7 @@ TableManagerResult TableManager::drop(const std::string& tableName){
     if(removeRes != 0){
         return TableManagerResult::droppingFaliure;
     }
+    std::remove(getFileName(tableName, TableFileType::freeSpaceMap).c_str());
     return TableManagerResult::droppedSuccessfully;
 }
 
@@ -136,7 +152,7 @@ TableManagerResult TableManager::closeAll(){
 void TableManager::flushAll(){
     for(auto& table: tableMap){
         if(table.second != nullptr && table.second->tableOpen){
-            table.second->pager->flushAll();
+            table.second->flushAll();
         }
     }
 }
@@ -148,6 +164,11 @@ bool TableManager::createIndex(std::shared_ptr<Table>& table, int32_t index){
     return true;
 }
 
+bool TableManager::createCoveringIndex(std::shared_ptr<Table>& table, const std::vector<int32_t>& keyColumns, const std::vector<int32_t>& included){
+    if(table == nullptr || keyColumns.empty()) return false;
+    return table->createCoveringIndex(keyColumns, included, getFileName(table->tableName, TableFileType::coveringIndex, keyColumns[0]));
+}
+
 std::string TableManager::getFileName(const std::string& tableName, TableFileType type, int32_t index){
     switch(type){
         case TableFileType::indexFile:
@@ -157,5 +178,10 @@ std::string TableManager::getFileName(const std::string& tableName, TableFileTyp
             return fileName;
         case TableFileType::baseTable:
             return baseURL + "/" + tableName + ".bin";
+        case TableFileType::freeSpaceMap:
+            return baseURL + "/" + tableName + ".fsm";
+        case TableFileType::coveringIndex:
+            if(index < 0) throw std::runtime_error("Invalid Index");
+            return baseURL + "/indexes/" + tableName + "_" + std::to_string(index) + ".cov";
     }
 }
\ No newline at end of file
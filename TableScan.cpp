@@ -0,0 +1,58 @@
+/// ---------------- CLASS DESCRIPTION ----------------
+/// TableScan is the sequential access path used when no index matches a condition
+/// It walks the table with a Cursor from Table::start() and skips deleted slots
+/// Condition is evaluated directly on serialized row bytes using PredicateKernel
+
+class TableScan{
+    Table* table;
+    Cursor cursor;
+    std::vector<row_t> freeRows;                /// Sorted deleted slots, snapshot taken at start
+    std::vector<row_t>::iterator nextFreeRow;
+    row_t numSlots;                             /// Slots when scan started, later rows are not visited
+    std::vector<PredicateKernel> kernels;
+    bool started;
+
+public:
+    TableScan(Table* table_, std::vector<PredicateKernel>&& kernels_): cursor(table_->start()){
+        table = table_;
+        freeRows = table->freeRowLocations();
+        nextFreeRow = freeRows.begin();
+        numSlots = table->numSlots();
+        kernels = std::move(kernels_);
+        started = false;
+    }
+
+    /// Moves to next live row satisfying all predicates
+    /// Returns pointer to that row in page or nullptr when table ends
+    /// Rows deleted after scan started are still skipped as their slot is behind the cursor
+    /// Rows written after scan started e.g. moved by an update went to slots that were free then and are skipped
+    char* next(){
+        if(started) ++cursor;
+        started = true;
+        for(; !cursor.endOfTable && cursor.row < numSlots; ++cursor){
+            while(nextFreeRow != freeRows.end() && *nextFreeRow < cursor.row) ++nextFreeRow;
+            if(nextFreeRow != freeRows.end() && *nextFreeRow == cursor.row) continue;
+
+            char* buffer = cursor.value();
+            if(buffer == nullptr) return nullptr;
+            bool matched = true;
+            for(auto& kernel: kernels){
+                if(!kernel.matches(buffer)){
+                    matched = false;
+                    break;
+                }
+            }
+            if(matched) return buffer;
+        }
+        return nullptr;
+    }
+
+    /// Row number of row returned by last call of next()
+    row_t row() const{
+        return cursor.row;
+    }
+
+    Cursor& current(){
+        return cursor;
+    }
+};
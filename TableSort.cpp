@@ -0,0 +1,86 @@
+/// ---------------- CLASS DESCRIPTION ----------------
+/// Sorts live rows of a Table on some of its columns using ExternalSort
+/// Key columns are located through columnOffsets and columnSizes of table, rows are
+/// read with its rowSize and deleted slots listed in its free space map are skipped.
+/// Sorted (key, row) records are read back in key order.
+///
+/// Used by order by. Records hold row numbers only, so reading rows back costs a heap read each.
+/// Index builds and joins read rows in table order instead, see buildIndex and HashJoin
+
+struct TableSortColumn{
+    int32_t index;                          /// Column of table
+    bool descending = false;
+};
+
+class TableSort{
+    Table* table;
+    SortKey key;
+    SortOptions options;
+    std::string sortedFileName;
+    bool sorted = false;
+
+public:
+    TableSort(Table* table_, const std::vector<TableSortColumn>& columns, const SortOptions& options_ = SortOptions()){
+        table = table_;
+        options = options_;
+        std::vector<SortColumn> sortColumns;
+        for(auto& column: columns){
+            sortColumns.push_back({table->columnTypes[column.index], (int32_t)table->columnOffsets[column.index],
+                                   (int32_t)table->columnSizes[column.index], column.descending});
+        }
+        key = SortKey(std::move(sortColumns));
+
+        // Sorts of the same table in flight at once, here or in another process, get their own file
+        sortedFileName = spillFilePrefix(options, "sorted_" + table->getTableName());
+    }
+
+    // Runs while an error of sort or scan is passed on, so removal mustn't throw
+    ~TableSort(){
+        std::error_code error;
+        if(sorted) std::filesystem::remove(sortedFileName, error);
+    }
+
+    const SortKey& getKey() const{
+        return key;
+    }
+
+    void sort(){
+        // ExternalSort reads table file directly so cached pages are written first
+        table->pager->flushAll();
+        std::vector<row_t> freeRows = table->freeRowLocations();
+        ExternalSort sorter(table->getFileName(), sortedFileName, table->numSlots(),
+                            std::move(freeRows), options);
+        // Pages are read from file as they are, so they are decompressed and decoded here
+        int32_t frameSize = table->pager->getFrameSize();
+        sorter.setPageSize(frameSize);
+        std::vector<char> page(table->pager->getPageSize());
+        if(table->pager->hasPageCompression()){
+            sorter.setPageDecoder(table->getRowsPerPage(), [this, &page](const char* frame, char* rows){
+                if(!table->pager->decodeFrame(frame, page.data())) throw std::runtime_error("Error reading file");
+                table->expandPage(page.data(), rows);
+            });
+        }
+        else if(table->getLayout() != TableLayout::rows){
+            sorter.setPageDecoder(table->getRowsPerPage(), [this](const char* page, char* rows){
+                table->expandPage(page, rows);
+            });
+        }
+        sorter.sort(table->getRowSize(), key, frameSize);
+        sorted = true;
+    }
+
+    /// Calls callback(row, normalized key) for every live row in key order until it returns false
+    /// Returns false if callback stopped the scan
+    template <typename callback_t>
+    bool scan(const callback_t& callback){
+        if(!sorted) sort();
+        int32_t recordSize = key.width + sizeof(row_t);
+        SpillScan records(sortedFileName, recordSize, spillBlockSize(recordSize, 1));
+        while(char* record = records.next()){
+            row_t row;
+            memcpy(&row, record + key.width, sizeof(row_t));
+            if(!callback(row, (const char*)record)) return false;
+        }
+        return true;
+    }
+};
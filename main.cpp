@@ -109,6 +109,9 @@ void runCommand(char* line){
             printw("There are no indexes for this table.\n"
                    "Create atleast one and then try again.\n");
             break;
+        case ExecuteResult::invalidAggregate:
+            printw("Selected columns must be aggregates or the group by column\n");
+            break;
         case ExecuteResult::unexpectedError:
             printw("Unexpected Error occured\n");
             break;